@@ -0,0 +1,33 @@
+#pragma once
+#include <concepts>
+#include <cstddef>
+#include <memory>
+
+// optional allocator extensions the containers probe for, an allocator without them (std::allocator) is used as is
+
+template <typename Pointer>
+struct allocation_result {
+    Pointer ptr;
+    std::size_t count;
+};
+
+// allocate_at_least(n) may hand out more than n elements, the block is given back as deallocate(ptr, count)
+template <class Alloc>
+concept allocates_at_least = requires(Alloc& alloc, std::size_t n) {
+    { alloc.allocate_at_least(n).ptr } -> std::convertible_to<typename std::allocator_traits<Alloc>::pointer>;
+    { alloc.allocate_at_least(n).count } -> std::convertible_to<std::size_t>;
+};
+
+// try_expand(ptr, n, new_n) grows the block at ptr to new_n elements without moving it and returns true,
+// or returns false and leaves the block as it was
+template <class Alloc>
+concept expandable_allocator = requires(Alloc& alloc, typename std::allocator_traits<Alloc>::pointer ptr, std::size_t n) {
+    { alloc.try_expand(ptr, n, n) } -> std::convertible_to<bool>;
+};
+
+// reallocate(ptr, n, new_n) works like realloc: the returned block of new_n elements holds the bytes of the first
+// min(n, new_n) and ptr is released, so it is only usable for trivially relocatable elements
+template <class Alloc>
+concept reallocating_allocator = requires(Alloc& alloc, typename std::allocator_traits<Alloc>::pointer ptr, std::size_t n) {
+    { alloc.reallocate(ptr, n, n) } -> std::convertible_to<typename std::allocator_traits<Alloc>::pointer>;
+};
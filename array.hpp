@@ -1,5 +1,6 @@
 #pragma once
 #include "arrayIterator.hpp"
+#include "simd_search.hpp"
 #include <cstdio>
 #include <cstring>
 
@@ -90,6 +91,26 @@ struct array {
         }
     }
 
+    [[nodiscard]] constexpr iterator find(const_reference val) {
+        return iterator(data() + simd_find(data(), size(), val));
+    }
+
+    [[nodiscard]] constexpr const_iterator find(const_reference val) const {
+        return const_iterator(data() + simd_find(data(), size(), val));
+    }
+
+    [[nodiscard]] constexpr size_type count(const_reference val) const {
+        return simd_count(data(), size(), val);
+    }
+
+    [[nodiscard]] constexpr bool contains(const_reference val) const {
+        return simd_find(data(), size(), val) != size();
+    }
+
+    [[nodiscard]] constexpr bool operator==(const array& other) const {
+        return simd_equal(data(), other.data(), size());
+    }
+
     [[nodiscard]] constexpr iterator begin() {
         return iterator(data());
     }
@@ -1,11 +1,14 @@
 #pragma once
 #include <iterator>
+#include <type_traits>
 template <typename T>
 class arrayIterator {
 public:
-    using iterator_category = std::contiguous_iterator_tag;
     friend class arrayIterator<const T>;
-    using value_type = T;
+    using iterator_category = std::contiguous_iterator_tag;
+    using iterator_concept = std::contiguous_iterator_tag;
+    using value_type = std::remove_const_t<T>;
+    using element_type = T;
     using size_type = std::size_t;
     using difference_type = std::ptrdiff_t;
     using pointer = T*;
@@ -13,20 +16,24 @@ public:
     using reference = T&;
     using const_reference = const T&;
 
-    explicit arrayIterator(pointer data) : m_data{data} {}
+    arrayIterator() = default;
 
-    arrayIterator(const arrayIterator& other) : m_data(other.m_data) {
-    }
+    explicit arrayIterator(pointer data) : m_data{data} {}
 
     constexpr operator arrayIterator<const T>() const {
         return arrayIterator<const T>(m_data);
     }
 
-    [[nodiscard]] constexpr reference operator*() {
+    [[nodiscard]] constexpr reference operator*() const {
         return *m_data;
     }
-    [[nodiscard]] constexpr const_reference operator*() const {
-        return *m_data;
+
+    [[nodiscard]] constexpr pointer operator->() const {
+        return m_data;
+    }
+
+    [[nodiscard]] constexpr reference operator[](difference_type index) const {
+        return m_data[index];
     }
 
     constexpr arrayIterator& operator++() {
@@ -51,25 +58,29 @@ public:
         return tmp;
     }
 
-    constexpr arrayIterator& operator+=(size_type val) {
-        std::advance(m_data, val);
+    constexpr arrayIterator& operator+=(difference_type val) {
+        m_data += val;
         return *this;
     }
 
-    constexpr arrayIterator& operator-=(size_type val) {
-        std::advance(m_data, -val);
+    constexpr arrayIterator& operator-=(difference_type val) {
+        m_data -= val;
         return *this;
     }
 
-    constexpr arrayIterator operator+(size_type val) {
+    [[nodiscard]] constexpr arrayIterator operator+(difference_type val) const {
         return arrayIterator(m_data + val);
     }
 
-    constexpr arrayIterator operator-(size_type val) {
+    [[nodiscard]] friend constexpr arrayIterator operator+(difference_type val, const arrayIterator& it) {
+        return it + val;
+    }
+
+    [[nodiscard]] constexpr arrayIterator operator-(difference_type val) const {
         return arrayIterator(m_data - val);
     }
 
-    constexpr size_type operator-(arrayIterator other) {
+    [[nodiscard]] constexpr difference_type operator-(const arrayIterator& other) const {
         return m_data - other.m_data;
     }
 
@@ -98,5 +109,5 @@ public:
     }
 
 private:
-    pointer m_data;
-};
\ No newline at end of file
+    T* m_data = nullptr;
+};
@@ -0,0 +1,155 @@
+#pragma once
+#include "hash_policy.hpp"
+#include "unordered_set_v1.hpp"
+#include <array>
+#include <bit>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+// unordered_set_v1 split into Shards independently locked shards, readers of a shard share its lock
+// so lookups only contend with writers that hash to the same shard
+template <typename T, class Hash = std::hash<T>, class KeyEqual = std::equal_to<T>, class Allocator = std::allocator<T>, std::size_t Shards = 16>
+class concurrent_unordered_set {
+public:
+    static_assert(Shards > 0 && (Shards & (Shards - 1)) == 0, "shard count must be a power of two");
+    using key_type = T;
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+    using reference = T&;
+    using const_reference = const T&;
+    using set_type = unordered_set_v1<T, Hash, KeyEqual, Allocator>;
+
+    static constexpr size_type shard_count = Shards;
+
+    concurrent_unordered_set() = default;
+
+    concurrent_unordered_set(const concurrent_unordered_set&) = delete;
+    concurrent_unordered_set& operator=(const concurrent_unordered_set&) = delete;
+
+    bool insert(const_reference val) {
+        shard& s = shard_for(val);
+        std::unique_lock lock(s.mutex);
+        return s.set.insert(val).second;
+    }
+
+    bool insert(value_type&& val) {
+        shard& s = shard_for(val);
+        std::unique_lock lock(s.mutex);
+        return s.set.insert(std::move(val)).second;
+    }
+
+    template <typename... Args>
+    bool emplace(Args&&... args) {
+        return insert(value_type(std::forward<Args>(args)...));
+    }
+
+    size_type erase(const_reference val) {
+        shard& s = shard_for(val);
+        std::unique_lock lock(s.mutex);
+        return s.set.erase(val);
+    }
+
+    [[nodiscard]] bool contains(const_reference val) const {
+        const shard& s = shard_for(val);
+        std::shared_lock lock(s.mutex);
+        return s.set.contains(val);
+    }
+
+    size_type count(const_reference val) const {
+        return contains(val) ? 1 : 0;
+    }
+
+    // f sees a copy of each shard taken under its lock, so f may call back into the set; shards are
+    // copied one after another, the result is not one atomic snapshot of the whole set
+    template <typename F>
+    void for_each(F f) const {
+        std::vector<value_type> copy;
+        for (const shard& s : m_shards) {
+            copy.clear();
+            {
+                std::shared_lock lock(s.mutex);
+                copy.reserve(s.set.size());
+                for (const_reference val : s.set)
+                    copy.push_back(val);
+            }
+            for (const_reference val : copy)
+                f(val);
+        }
+    }
+
+    [[nodiscard]] std::vector<value_type> snapshot() const {
+        std::vector<value_type> copy;
+        for_each([&copy](const_reference val) { copy.push_back(val); });
+        return copy;
+    }
+
+    // spread evenly, keys are assumed to hash uniformly across shards
+    void reserve(size_type count) {
+        for (shard& s : m_shards) {
+            std::unique_lock lock(s.mutex);
+            s.set.reserve(count / Shards + 1);
+        }
+    }
+
+    void clear() {
+        for (shard& s : m_shards) {
+            std::unique_lock lock(s.mutex);
+            s.set.clear();
+        }
+    }
+
+    [[nodiscard]] size_type size() const {
+        size_type acc = 0;
+        for (const shard& s : m_shards) {
+            std::shared_lock lock(s.mutex);
+            acc += s.set.size();
+        }
+        return acc;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return size() == 0;
+    }
+
+    [[nodiscard]] hasher hash_function() const {
+        return hasher{};
+    }
+
+    [[nodiscard]] key_equal key_eq() const {
+        return key_equal{};
+    }
+
+private:
+    // own cache line per shard so writers on neighbouring shards do not bounce each other's lock
+    struct alignas(64) shard {
+        mutable std::shared_mutex mutex;
+        set_type set;
+    };
+
+    // shard from the high bits, the bucket index inside the shard comes from the low bits
+    [[nodiscard]] static size_type shard_index(const_reference val) {
+        if constexpr (Shards == 1)
+            return 0;
+        else
+            return fibonacci_mixer{}(Hash{}(val)) >> (std::numeric_limits<size_type>::digits - std::countr_zero(Shards));
+    }
+
+    [[nodiscard]] shard& shard_for(const_reference val) {
+        return m_shards[shard_index(val)];
+    }
+
+    [[nodiscard]] const shard& shard_for(const_reference val) const {
+        return m_shards[shard_index(val)];
+    }
+
+    std::array<shard, Shards> m_shards;
+};
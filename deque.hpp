@@ -1,13 +1,19 @@
 #pragma once
 #include "dequeIterator.hpp"
+#include <algorithm>
 #include <bit>
 #include <concepts>
 #include <cstring>
 #include <iterator>
 #include <memory>
+#include <span>
+#include <type_traits>
 #include <utility>
-template <typename T, class Alloc = std::allocator<T>>
+// BlockSize is the number of elements per block, a power of two; the default targets 4 KiB blocks
+template <typename T, class Alloc = std::allocator<T>, std::size_t BlockSize = deque_block_size<T>>
 class deque {
+    static_assert(std::has_single_bit(BlockSize) && BlockSize >= 4, "deque block size must be a power of two, at least 4");
+
 public:
     using value_type = T;
     using size_type = std::size_t;
@@ -18,47 +24,38 @@ public:
     using const_pointer = const T*;
     using allocator_type = Alloc;
     using array_allocator = typename std::allocator_traits<Alloc>::template rebind_alloc<T*>;
-    using iterator = dequeIterator<T>;
-    using const_iterator = dequeIterator<const T>;
-    using reverse_iterator = std::reverse_iterator<dequeIterator<T>>;
-    using const_reverse_iterator = std::reverse_iterator<dequeIterator<const T>>;
-    static constexpr size_type block_size = dequeIterator<value_type>::block_size;
-    // using block size from iterator
+    using iterator = dequeIterator<T, BlockSize>;
+    using const_iterator = dequeIterator<const T, BlockSize>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    static constexpr size_type block_size = BlockSize;
 
+    // nothing is allocated until the first element goes in
     deque() : m_alloc{}, m_before_first{block_size / 2}, m_after_last{block_size / 2 + 1}, m_size{0}, m_data{nullptr} { // 4 , 5
-        grow_right(2);
     }
 
     explicit deque(allocator_type alloc) : m_alloc{alloc}, m_before_first{block_size / 2}, m_after_last{block_size / 2 + 1}, m_size{0}, m_data{nullptr} { // 4 , 5
-        grow_right(2);
     }
 
     explicit deque(size_type count, allocator_type alloc = allocator_type{}) : m_alloc{alloc}, m_before_first{block_size / 2}, m_after_last{block_size / 2 + 1}, m_size{0}, m_data{nullptr} { // 4 , 5
-        grow_right(std::max<size_type>(count / block_size + 1, 2));
         assign(count, value_type{});
     }
 
     deque(size_type count, const_reference val, allocator_type alloc = allocator_type{}) : m_alloc{alloc}, m_before_first{block_size / 2}, m_after_last{block_size / 2 + 1}, m_size{0}, m_data{nullptr} { // 4 , 5
-        grow_right(std::max<size_type>(count / block_size + 1, 2));
         assign(count, val);
     }
 
-    template <typename It>
+    template <std::input_iterator It>
     deque(It first, It last, allocator_type alloc = allocator_type{})
-        requires requires(It it) { It::iterator_category; }
         : m_alloc{alloc}, m_before_first{block_size / 2}, m_after_last{block_size / 2 + 1}, m_size{0}, m_data{nullptr} { // 4 , 5
-        if constexpr (std::is_same_v<typename It::iterator_category, std::random_access_iterator_tag>) {
-            grow_right(std::max<size_type>((last - first) / block_size + 1, 2));
-        } else {
-            grow_right(2);
-        }
         assign(first, last);
     }
 
     deque(const deque& other) : deque(other.cbegin(), other.cend()) {
     }
 
-    deque(deque&& other) noexcept : m_alloc{other.m_alloc}, m_before_first{std::exchange(other.m_before_first, block_size / 2)}, m_after_last{std::exchange(other.m_after_last, block_size / 2 + 1)}, m_size{std::exchange(other.m_size, 0)}, m_data{std::exchange(other.m_data, nullptr)} {
+    deque(deque&& other) noexcept : m_alloc{other.m_alloc}, m_before_first{std::exchange(other.m_before_first, block_size / 2)}, m_after_last{std::exchange(other.m_after_last, block_size / 2 + 1)}, m_size{std::exchange(other.m_size, 0)}, m_data{std::exchange(other.m_data, nullptr)}, m_spares{std::exchange(other.m_spares, 0)} {
+        std::copy_n(other.m_spare, m_spares, m_spare);
     }
 
     deque& operator=(deque other) {
@@ -67,50 +64,31 @@ public:
     }
 
     deque(std::initializer_list<value_type>& ilist, const allocator_type& alloc = allocator_type{}) : m_alloc{alloc}, m_before_first{block_size / 2}, m_after_last{block_size / 2 + 1}, m_size{0}, m_data{nullptr} { // 4 , 5
-        grow_right(std::max<size_type>(ilist.size() / block_size + 1, 2));
         assign(ilist);
     }
 
     ~deque() {
         clear();
-        deallocate(0, m_size);
-        array_allocator{}.deallocate(m_data, m_size);
+        free_storage();
     }
 
-    auto shrink_to_fit() -> void {
-        // WARNING NEED TO FIX ! !
-        difference_type first = m_before_first / block_size; // block with before first element
-        difference_type last = m_after_last / block_size;    // block with after last element
-        size_type count = last - first + 1;
-        size_type new_size = std::bit_ceil(count + 1);
-        if (new_size == m_size)
+    // frees the spare blocks and cuts the map down to the blocks in use
+    void shrink_to_fit() {
+        while (m_spares != 0)
+            deallocate_block(m_spare[--m_spares]);
+        if (m_data == nullptr)
             return;
-        T** new_data = array_allocator{}.allocate(new_size);
-        std::memcpy(new_data + (new_size - count), m_data + first, count * sizeof(T*)); // what if it is bigger
-        size_type i = 0;
-        size_type j = 0;
-        for (; i < m_size && j < new_size - count; i++) {
-            if (i < first || i > last) {
-                new_data[j++] = m_data[i];
-            }
-        }
-        for (; j < new_size - count; j++) {
-            new_data[j] = std::allocator_traits<allocator_type>::allocate(m_alloc, block_size);
-        }
-
-        for (; i < m_size; i++) {
-            if (i < first || i > last) {
-                std::allocator_traits<allocator_type>::deallocate(m_alloc, m_data[i], block_size);
-            }
-        }
-        // first is curr positiion
-        // new_size - count is next position
-        m_before_first += block_size * (new_size - count - first);
-        m_after_last += block_size * (new_size - count - first);
+        size_type first = m_before_first / block_size;
+        size_type used = end_block() - first;
+        if (used == m_size)
+            return;
+        T** new_data = array_allocator{}.allocate(used);
+        std::memcpy(new_data, m_data + first, used * sizeof(T*));
         array_allocator{}.deallocate(m_data, m_size);
         m_data = new_data;
-        m_size = new_size;
-        // need to free memory
+        m_size = used;
+        m_before_first -= first * block_size;
+        m_after_last -= first * block_size;
     }
 
     iterator erase(const_iterator pos) {
@@ -118,30 +96,33 @@ public:
     }
 
     iterator erase(const_iterator first, const_iterator last) {
-        for (int i = first - cbegin(), j = last - cbegin(); j < size(); i++, j++) {
-            this->operator[](i) = std::move(this->operator[](j));
-        }
-        m_size -= (last - first);
-        return iterator(m_data, first - cbegin());
+        size_type index = first - cbegin();
+        size_type count = last - first;
+        if (count == 0)
+            return begin() + index;
+        std::move(begin() + index + count, end(), begin() + index);
+        while (count--)
+            pop_back();
+        return begin() + index;
     }
 
     void assign(size_type count, const_reference val) {
         clear();
+        if (count != 0)
+            reserve_back(count);
         while (count--)
             push_back(val);
     }
 
-    template <typename It>
+    template <std::input_iterator It>
     void assign(It first, It last) {
         clear();
-        while (first != last)
-            push_back(*first++);
+        append(first, last);
     }
 
     void assign(std::initializer_list<value_type>& ilist) {
         clear();
-        for (const_reference val : ilist)
-            push_back(val);
+        append(ilist.begin(), ilist.end());
     }
 
     void resize(size_type count, const_reference val = value_type{}) {
@@ -191,49 +172,17 @@ public:
         return begin() + index;
     }
 
-    template <typename It>
-    iterator insert(const_iterator pos, It first, It last)
-        requires requires(It) { It::iterator_category; }
-    {
-        // requires iterator trait
-        //  work needen
-        //  check if const_iterator works becouse we need just index not iterator
-        using std::swap;
+    template <std::input_iterator It>
+    iterator insert(const_iterator pos, It first, It last) {
         size_type index = pos - cbegin();
-        size_type count = 0;
-        while (first != last)
-            push_back(*first++);
-        size_type end = size() - 1;
-        for (size_type i = index; i < end; i++, end--)
-            swap(this->operator[](i), this->operator[](end));
-        end = index + count - 1;
-        for (size_type i = index; i < end; i++, end--)
-            swap(this->operator[](i), this->operator[](end));
-        end = size() - 1;
-        for (size_type i = index + count; i < end; i++, end--)
-            swap(this->operator[](i), this->operator[](end));
+        size_type old_size = size();
+        append(first, last);
+        std::rotate(begin() + index, begin() + old_size, end());
         return begin() + index;
     }
 
     iterator insert(const_iterator pos, std::initializer_list<value_type>& ilist) {
-        // work needen
-        // check if const_iterator works becouse we need just index not iterator
-        using std::swap;
-        size_type index = pos - cbegin();
-        size_type count = 0;
-
-        for (const_reference val : ilist)
-            push_back(val);
-        size_type end = size() - 1;
-        for (size_type i = index; i < end; i++, end--)
-            swap(this->operator[](i), this->operator[](end));
-        end = index + count - 1;
-        for (size_type i = index; i < end; i++, end--)
-            swap(this->operator[](i), this->operator[](end));
-        end = size() - 1;
-        for (size_type i = index + count; i < end; i++, end--)
-            swap(this->operator[](i), this->operator[](end));
-        return begin() + index;
+        return insert(pos, ilist.begin(), ilist.end());
     }
 
     template <typename... Args>
@@ -292,47 +241,111 @@ public:
 
     template <typename... Args>
     reference emplace_back(Args&&... args) {
-        std::allocator_traits<allocator_type>::construct(m_alloc, &(this->operator[](size())), std::forward<Args>(args)...);
-        if (++m_after_last >= block_size * m_size)
-            grow_right(m_size * 2);
+        reserve_back(1);
+        T* slot = block_at(m_after_last);
+        std::allocator_traits<allocator_type>::construct(m_alloc, slot, std::forward<Args>(args)...);
+        ++m_after_last;
+        return *slot;
     }
 
-    constexpr void push_back(const_reference val) {
-        std::allocator_traits<allocator_type>::construct(m_alloc, &(this->operator[](size())), val);
-        if (++m_after_last >= block_size * m_size)
-            grow_right(m_size * 2);
+    void push_back(const_reference val) {
+        emplace_back(val);
     }
 
-    constexpr void push_back(value_type&& val) {
-        std::allocator_traits<allocator_type>::construct(m_alloc, &(this->operator[](size())), std::move(val));
-        if (++m_after_last >= block_size * m_size)
-            grow_right(m_size * 2);
+    void push_back(value_type&& val) {
+        emplace_back(std::move(val));
     }
 
     template <typename... Args>
     reference emplace_front(Args&&... args) {
-        std::allocator_traits<allocator_type>::construct(m_alloc, &(m_data[m_before_first / block_size][m_before_first % block_size]), std::forward<Args>(args)...);
-        if (--m_before_first <= 1)
-            grow_left(m_size * 2);
+        reserve_front(1);
+        T* slot = block_at(m_before_first);
+        std::allocator_traits<allocator_type>::construct(m_alloc, slot, std::forward<Args>(args)...);
+        --m_before_first;
+        return *slot;
+    }
+
+    void push_front(const_reference val) {
+        emplace_front(val);
+    }
+
+    void push_front(value_type&& val) {
+        emplace_front(std::move(val));
+    }
+
+    // appends [first, last) after making room once, then fills block by block: one memcpy per block when the
+    // source is contiguous and the elements trivially copyable, no per element index arithmetic otherwise
+    template <std::input_iterator It>
+    void append(It first, It last) {
+        if constexpr (std::forward_iterator<It>) {
+            size_type count = std::distance(first, last);
+            if (count == 0)
+                return;
+            reserve_back(count);
+            while (count != 0) {
+                size_type n = std::min<size_type>(count, block_size - m_after_last % block_size);
+                fill_block(block_at(m_after_last), first, n, m_after_last);
+                count -= n;
+            }
+        } else {
+            while (first != last)
+                push_back(*first++);
+        }
+    }
+
+    // inserts [first, last) in front keeping its order, *first becomes front()
+    template <std::forward_iterator It>
+    void prepend(It first, It last) {
+        size_type count = std::distance(first, last);
+        if (count == 0)
+            return;
+        reserve_front(count);
+        size_type start = m_before_first + 1 - count;
+        size_type pos = start;
+        try {
+            for (size_type left = count; left != 0;) {
+                size_type n = std::min<size_type>(left, block_size - pos % block_size);
+                fill_block(block_at(pos), first, n, pos);
+                left -= n;
+            }
+        } catch (...) {
+            // the part already built is not joined to the front yet, nor are the blocks taken for it
+            for (; pos != start; --pos)
+                std::allocator_traits<allocator_type>::destroy(m_alloc, &m_data[(pos - 1) / block_size][(pos - 1) % block_size]);
+            for (size_type block = start / block_size; block < m_before_first / block_size; ++block)
+                release_block(block);
+            throw;
+        }
+        m_before_first -= count;
     }
 
-    constexpr void push_front(const_reference val) {
-        std::allocator_traits<allocator_type>::construct(m_alloc, &(m_data[m_before_first / block_size][m_before_first % block_size]), val);
-        if (--m_before_first <= 1)
-            grow_left(m_size * 2);
+    // calls f once per block that holds elements, with a span over just those elements, front to back
+    template <typename F>
+    void for_each_block(F f) {
+        for (size_type pos = m_before_first + 1; pos < m_after_last;) {
+            size_type n = std::min<size_type>(m_after_last - pos, block_size - pos % block_size);
+            f(std::span<value_type>(m_data[pos / block_size] + pos % block_size, n));
+            pos += n;
+        }
     }
 
-    constexpr void push_front(value_type&& val) {
-        std::allocator_traits<allocator_type>::construct(m_alloc, &(m_data[m_before_first / block_size][m_before_first % block_size]), std::move(val));
-        if (--m_before_first <= 1)
-            grow_left(m_size * 2);
+    template <typename F>
+    void for_each_block(F f) const {
+        for (size_type pos = m_before_first + 1; pos < m_after_last;) {
+            size_type n = std::min<size_type>(m_after_last - pos, block_size - pos % block_size);
+            f(std::span<const value_type>(m_data[pos / block_size] + pos % block_size, n));
+            pos += n;
+        }
     }
 
+    // a block left empty goes back to the spare cache
     auto pop_back() -> void {
         --m_after_last;
         if constexpr (!std::is_trivially_destructible_v<value_type>) {
             std::allocator_traits<allocator_type>::destroy(m_alloc, &(this->operator[](size())));
         }
+        if ((m_after_last + 1) % block_size == 0)
+            release_block((m_after_last + 1) / block_size);
     }
 
     auto pop_front() -> void {
@@ -340,40 +353,8 @@ public:
         if constexpr (!std::is_trivially_destructible_v<value_type>) {
             std::allocator_traits<allocator_type>::destroy(m_alloc, &(m_data[m_before_first / block_size][m_before_first % block_size]));
         }
-    }
-
-    // array of ptr to blocks
-    void grow_right(size_type new_size) {
-        new_size = std::bit_ceil(new_size);
-        T** new_data = array_allocator{}.allocate(new_size);
-        std::memcpy(new_data, m_data, m_size * sizeof(T*));
-        for (size_type i = m_size; i < new_size; i++) {
-            new_data[i] = m_alloc.allocate(block_size);
-        }
-        array_allocator{}.deallocate(m_data, m_size);
-        m_data = new_data;
-        m_size = new_size;
-    }
-
-    void grow_left(size_type new_size) {
-        new_size = std::bit_ceil(new_size);
-        size_type offset = new_size - m_size;
-        T** new_data = array_allocator{}.allocate(new_size);
-        std::memcpy(new_data + offset, m_data, m_size * sizeof(T*));
-        for (size_type i = 0; i < offset; i++) {
-            new_data[i] = m_alloc.allocate(block_size);
-        }
-        array_allocator{}.deallocate(m_data, m_size);
-        m_data = new_data;
-        m_size = new_size;
-        m_after_last += offset * block_size;
-        m_before_first += offset * block_size;
-    }
-
-    void deallocate(int first, int last) {
-        while (first != last) {
-            std::allocator_traits<allocator_type>::deallocate(m_alloc, m_data[first++], block_size);
-        }
+        if (m_before_first % block_size == 0)
+            release_block(m_before_first / block_size - 1);
     }
 
     // destroy is pop_back
@@ -403,7 +384,7 @@ public:
         return const_iterator(const_cast<const T**>(m_data), m_before_first + 1);
     }
 
-    [[nodiscard]] constexpr iterator begin() const {
+    [[nodiscard]] constexpr const_iterator begin() const {
         return cbegin();
     }
 
@@ -415,7 +396,7 @@ public:
         return const_reverse_iterator(cend());
     }
 
-    [[nodiscard]] constexpr reverse_iterator rbegin() const {
+    [[nodiscard]] constexpr const_reverse_iterator rbegin() const {
         return crbegin();
     }
 
@@ -427,7 +408,7 @@ public:
         return const_iterator(const_cast<const T**>(m_data), m_after_last);
     }
 
-    [[nodiscard]] constexpr iterator end() const {
+    [[nodiscard]] constexpr const_iterator end() const {
         return cend();
     }
 
@@ -439,7 +420,7 @@ public:
         return const_reverse_iterator(cbegin());
     }
 
-    [[nodiscard]] constexpr reverse_iterator rend() const {
+    [[nodiscard]] constexpr const_reverse_iterator rend() const {
         return crend();
     }
 
@@ -450,12 +431,125 @@ public:
         swap(other.m_after_last, m_after_last);
         swap(other.m_size, m_size);
         swap(other.m_data, m_data);
+        swap(other.m_spare, m_spare);
+        swap(other.m_spares, m_spares);
     }
 
 private:
+    // blocks emptied by pops are kept for the next push to cross a block boundary, so a deque used as a queue
+    // stops allocating once it reaches its working size
+    static constexpr size_type spare_blocks = 2;
+
+    // the map holds blocks only from the one of m_before_first up to the one of m_after_last (when that is still
+    // inside the map); blocks are taken on the first write into them, so the two end ones may be null
+
+    [[nodiscard]] size_type end_block() const noexcept {
+        return std::min(m_after_last / block_size + 1, m_size);
+    }
+
+    // address of a position, taking a block for it if it has none yet
+    T* block_at(size_type pos) {
+        T*& block = m_data[pos / block_size];
+        if (block == nullptr)
+            block = take_block();
+        return block + pos % block_size;
+    }
+
+    T* take_block() {
+        if (m_spares != 0)
+            return m_spare[--m_spares];
+        return std::allocator_traits<allocator_type>::allocate(m_alloc, block_size);
+    }
+
+    void release_block(size_type index) noexcept {
+        if (index >= m_size || m_data[index] == nullptr)
+            return;
+        if (m_spares < spare_blocks) {
+            m_spare[m_spares++] = m_data[index];
+        } else {
+            deallocate_block(m_data[index]);
+        }
+        m_data[index] = nullptr;
+    }
+
+    void deallocate_block(T* block) noexcept {
+        std::allocator_traits<allocator_type>::deallocate(m_alloc, block, block_size);
+    }
+
+    void free_storage() noexcept {
+        for (size_type i = 0; i < m_size; i++) {
+            if (m_data[i] != nullptr)
+                deallocate_block(m_data[i]);
+        }
+        while (m_spares != 0)
+            deallocate_block(m_spare[--m_spares]);
+        if (m_data != nullptr)
+            array_allocator{}.deallocate(m_data, m_size);
+    }
+
+    // makes the map reach count positions past m_after_last
+    void reserve_back(size_type count) {
+        size_type last = (m_after_last + count - 1) / block_size;
+        if (last < m_size)
+            return;
+        grow_map(last + 1 - end_block(), false);
+    }
+
+    // makes the map reach count positions before m_before_first, which never wraps below zero
+    void reserve_front(size_type count) {
+        if (m_data != nullptr && m_before_first >= count)
+            return;
+        size_type offset = m_before_first % block_size;
+        grow_map(count > offset ? (count - offset + block_size - 1) / block_size : 0, true);
+    }
+
+    // frees extra map slots at one end: the blocks in use are recentered when the map is over twice what they
+    // need, otherwise they move to a map twice the size; no block is allocated or freed either way
+    void grow_map(size_type extra, bool at_front) {
+        size_type first = m_before_first / block_size;
+        size_type used = m_size == 0 ? 0 : end_block() - first;
+        size_type new_used = used + extra;
+        size_type new_first;
+        if (m_size > 2 * new_used) {
+            new_first = (m_size - new_used) / 2 + (at_front ? extra : 0);
+            std::memmove(m_data + new_first, m_data + first, used * sizeof(T*));
+            std::fill(m_data, m_data + new_first, nullptr);
+            std::fill(m_data + new_first + used, m_data + m_size, nullptr);
+        } else {
+            size_type new_size = std::max<size_type>({m_size * 2, new_used * 2, 8});
+            T** new_data = array_allocator{}.allocate(new_size);
+            new_first = (new_size - new_used) / 2 + (at_front ? extra : 0);
+            std::fill(new_data, new_data + new_size, nullptr);
+            if (m_data != nullptr) {
+                std::memcpy(new_data + new_first, m_data + first, used * sizeof(T*));
+                array_allocator{}.deallocate(m_data, m_size);
+            }
+            m_data = new_data;
+            m_size = new_size;
+        }
+        m_before_first = m_before_first - first * block_size + new_first * block_size;
+        m_after_last = m_after_last - first * block_size + new_first * block_size;
+    }
+
+    // constructs n elements from first at dest, which lie inside one block, advancing pos past each one built
+    template <typename It>
+    void fill_block(T* dest, It& first, size_type n, size_type& pos) {
+        if constexpr (std::contiguous_iterator<It> && std::is_trivially_copyable_v<value_type> &&
+                      std::is_same_v<std::iter_value_t<It>, value_type>) {
+            std::memcpy(static_cast<void*>(dest), std::to_address(first), n * sizeof(value_type));
+            first += n;
+            pos += n;
+        } else {
+            for (size_type i = 0; i < n; ++i, ++first, ++pos)
+                std::allocator_traits<allocator_type>::construct(m_alloc, dest + i, *first);
+        }
+    }
+
     [[no_unique_address]] allocator_type m_alloc;
     size_type m_before_first;
     size_type m_after_last;
     size_type m_size;
     T** m_data;
+    T* m_spare[spare_blocks] = {};
+    size_type m_spares = 0;
 };
\ No newline at end of file
@@ -1,23 +1,36 @@
 #pragma once
+#include <algorithm>
+#include <bit>
+#include <cstddef>
 #include <iterator>
+#include <type_traits>
 
-template <typename T>
+// elements per deque block: as many as fit in Bytes, never under 16, rounded down to a power of two so the
+// block index and offset of a position are a shift and a mask
+template <typename T, std::size_t Bytes = 4096>
+inline constexpr std::size_t deque_block_size = std::bit_floor(std::max<std::size_t>(Bytes / sizeof(T), 16));
+
+template <typename T, std::size_t BlockSize = deque_block_size<std::remove_const_t<T>>>
 class dequeIterator{
     public:
+    friend class dequeIterator<const T, BlockSize>;
     using iterator_category = std::random_access_iterator_tag;
+    using pointer = T*;
     using reference = T&;
     using const_reference = const T&;
-    using value_type = T;
+    using value_type = std::remove_const_t<T>;
     using size_type = std::size_t;
     using difference_type = std::ptrdiff_t;
-    static constexpr difference_type block_size = sizeof(T) <= 4 ? 16 : 8;
+    static constexpr size_type block_size = BlockSize;
+
+    dequeIterator() = default;
 
     dequeIterator(T** data,size_type pos) : mData(data) , mPos(pos){
 
     }
 
-    operator dequeIterator<const T>() {
-        return dequeIterator<const T>(const_cast<const T**>(mData),mPos);
+    operator dequeIterator<const T, BlockSize>() const {
+        return dequeIterator<const T, BlockSize>(const_cast<const T**>(mData),mPos);
     }
 
     constexpr dequeIterator& operator++(){
@@ -30,18 +43,28 @@ class dequeIterator{
         return *this;
     }
 
-    constexpr dequeIterator& operator++(int){
-        dequeIterator temp = *this; 
+    constexpr dequeIterator operator++(int){
+        dequeIterator temp = *this;
         ++(*this);
         return temp;
     }
 
-    constexpr dequeIterator& operator--(int){
-        dequeIterator temp = *this; 
+    constexpr dequeIterator operator--(int){
+        dequeIterator temp = *this;
         --(*this);
         return temp;
     }
 
+    constexpr dequeIterator& operator+=(difference_type count){
+        mPos += count;
+        return *this;
+    }
+
+    constexpr dequeIterator& operator-=(difference_type count){
+        mPos -= count;
+        return *this;
+    }
+
     [[nodiscard]] constexpr bool operator==(const dequeIterator& other) const noexcept{
         return mData == other.mData && mPos==other.mPos;
     }
@@ -50,27 +73,51 @@ class dequeIterator{
         return !(*this==other);
     }
 
-    constexpr reference operator*(){
+    [[nodiscard]] constexpr bool operator<(const dequeIterator& other) const noexcept{
+        return mPos < other.mPos;
+    }
+
+    [[nodiscard]] constexpr bool operator>(const dequeIterator& other) const noexcept{
+        return mPos > other.mPos;
+    }
+
+    [[nodiscard]] constexpr bool operator<=(const dequeIterator& other) const noexcept{
+        return mPos <= other.mPos;
+    }
+
+    [[nodiscard]] constexpr bool operator>=(const dequeIterator& other) const noexcept{
+        return mPos >= other.mPos;
+    }
+
+    [[nodiscard]] constexpr reference operator*() const {
         return mData[mPos/block_size][mPos%block_size];
     }
 
-    [[nodiscard]] constexpr size_type operator-(const dequeIterator& other) const {
-        return mPos-other.mPos;
+    [[nodiscard]] constexpr pointer operator->() const {
+        return &**this;
     }
 
-    [[nodiscard]] constexpr size_type operator+(const dequeIterator& other) const {
-        return mPos+other.mPos;
+    [[nodiscard]] constexpr reference operator[](difference_type index) const {
+        return *(*this + index);
     }
 
-    [[nodiscard]] constexpr dequeIterator operator-(size_type count) const {
-        return dequeIterator(mData,mPos+count);
+    [[nodiscard]] constexpr difference_type operator-(const dequeIterator& other) const {
+        return static_cast<difference_type>(mPos) - static_cast<difference_type>(other.mPos);
+    }
+
+    [[nodiscard]] constexpr dequeIterator operator-(difference_type count) const {
+        return dequeIterator(mData,mPos-count);
     }
 
-    [[nodiscard]] constexpr dequeIterator operator+(size_type count) const {
+    [[nodiscard]] constexpr dequeIterator operator+(difference_type count) const {
         return dequeIterator(mData,mPos+count);
     }
 
+    [[nodiscard]] friend constexpr dequeIterator operator+(difference_type count, const dequeIterator& it) {
+        return it + count;
+    }
+
     private:
-    T** mData;
-    size_type mPos;
-};
\ No newline at end of file
+    T** mData = nullptr;
+    size_type mPos = 0;
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+
+// vector growth policies: grow picks the new capacity when an insert needs at least required elements,
+// reserve picks the capacity for an explicit reserve(count); both get sizeof the element for byte based rounding
+
+// double on growth, reserve rounds up to a power of two
+struct power_of_two_growth {
+    [[nodiscard]] static constexpr std::size_t grow(std::size_t capacity, std::size_t required, std::size_t) noexcept {
+        return std::max(capacity * 2, required);
+    }
+
+    [[nodiscard]] static constexpr std::size_t reserve(std::size_t count, std::size_t) noexcept {
+        return std::bit_ceil(count);
+    }
+};
+
+// multiply by Num / Den on growth, reserve gives exactly what was asked for
+template <std::size_t Num, std::size_t Den = 1>
+struct factor_growth {
+    static_assert(Num > Den, "growth factor must be above one");
+
+    [[nodiscard]] static constexpr std::size_t grow(std::size_t capacity, std::size_t required, std::size_t) noexcept {
+        return std::max(capacity * Num / Den, required);
+    }
+
+    [[nodiscard]] static constexpr std::size_t reserve(std::size_t count, std::size_t) noexcept {
+        return count;
+    }
+};
+
+using doubling_growth = factor_growth<2>;
+using one_and_half_growth = factor_growth<3, 2>;
+
+// capacities of Bytes or more are rounded up to a whole multiple of Bytes, so a large buffer ends on a page
+// (or huge page) boundary and the tail the allocator maps anyway is usable; smaller ones are left to Base
+template <class Base, std::size_t Bytes>
+struct rounded_growth {
+    static_assert(Bytes > 0 && (Bytes & (Bytes - 1)) == 0, "rounding must be a power of two");
+
+    [[nodiscard]] static constexpr std::size_t grow(std::size_t capacity, std::size_t required, std::size_t element_size) noexcept {
+        return round(Base::grow(capacity, required, element_size), element_size);
+    }
+
+    [[nodiscard]] static constexpr std::size_t reserve(std::size_t count, std::size_t element_size) noexcept {
+        return round(Base::reserve(count, element_size), element_size);
+    }
+
+private:
+    [[nodiscard]] static constexpr std::size_t round(std::size_t count, std::size_t element_size) noexcept {
+        std::size_t bytes = count * element_size;
+        if (bytes < Bytes)
+            return count;
+        return ((bytes + Bytes - 1) & ~(Bytes - 1)) / element_size;
+    }
+};
+
+template <class Base = one_and_half_growth>
+using page_growth = rounded_growth<Base, 4096>;
+
+template <class Base = one_and_half_growth>
+using huge_page_growth = rounded_growth<Base, std::size_t{2} << 20>;
@@ -0,0 +1,91 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+// true when Hash{}(key) is about as cheap as comparing two size_t, so storing the hash next to the key buys nothing
+// specialize for your own hashers
+template <class Hash, typename T>
+struct is_fast_hash : std::false_type {};
+
+template <typename T>
+    requires(std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>)
+struct is_fast_hash<std::hash<T>, T> : std::true_type {};
+
+template <class Hash, typename T>
+inline constexpr bool is_fast_hash_v = is_fast_hash<Hash, T>::value;
+
+// both functors accept any key type they can compare, so lookups need not build a temporary key
+template <class Hash, class KeyEqual>
+concept transparent_hash = requires {
+    typename Hash::is_transparent;
+    typename KeyEqual::is_transparent;
+};
+
+// hint that addr is about to be read, used to overlap bucket cache misses during bulk inserts
+inline void prefetch_read([[maybe_unused]] const void* addr) noexcept {
+#if defined(__GNUC__)
+    __builtin_prefetch(addr, 0, 3);
+#endif
+}
+
+// post-hash mixers, applied before a bucket index is taken from the low bits
+
+struct identity_mixer {
+    [[nodiscard]] constexpr std::size_t operator()(std::size_t hash) const noexcept {
+        return hash;
+    }
+};
+
+// multiply by 2^64 / golden ratio and fold the high half down, std::hash<int> is the identity so
+// without this consecutive keys would only ever differ in the lowest bits
+struct fibonacci_mixer {
+    [[nodiscard]] constexpr std::size_t operator()(std::size_t hash) const noexcept {
+        std::uint64_t x = static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<std::size_t>(x ^ (x >> 32));
+    }
+};
+
+// bucket index policies: bucket_count rounds a requested count to one the policy can index,
+// index maps a full hash to [0, bucket_count)
+
+// power of two bucket counts, index is a mask instead of a division
+template <class Mixer = fibonacci_mixer>
+struct power_of_two_bucket_policy {
+    [[nodiscard]] static constexpr std::size_t bucket_count(std::size_t count) noexcept {
+        return std::bit_ceil(std::max<std::size_t>(count, 1));
+    }
+
+    [[nodiscard]] static constexpr std::size_t index(std::size_t hash, std::size_t bucket_count) noexcept {
+        return Mixer{}(hash) & (bucket_count - 1);
+    }
+};
+
+// prime bucket counts roughly doubling, for hashes whose low bits are poor and cannot be mixed
+struct prime_bucket_policy {
+    [[nodiscard]] static constexpr std::size_t bucket_count(std::size_t count) noexcept {
+        return *std::lower_bound(primes.begin(), primes.end() - 1, static_cast<std::uint64_t>(count));
+    }
+
+    [[nodiscard]] static constexpr std::size_t index(std::size_t hash, std::size_t bucket_count) noexcept {
+        return hash % bucket_count;
+    }
+
+private:
+    // smallest prime above each power of two from 2^2 to 2^63
+    static constexpr std::array<std::uint64_t, 62> primes = {
+        5ULL, 11ULL, 17ULL, 37ULL, 67ULL, 131ULL, 257ULL, 521ULL, 1031ULL, 2053ULL, 4099ULL, 8209ULL, 16411ULL,
+        32771ULL, 65537ULL, 131101ULL, 262147ULL, 524309ULL, 1048583ULL, 2097169ULL, 4194319ULL, 8388617ULL,
+        16777259ULL, 33554467ULL, 67108879ULL, 134217757ULL, 268435459ULL, 536870923ULL, 1073741827ULL,
+        2147483659ULL, 4294967311ULL, 8589934609ULL, 17179869209ULL, 34359738421ULL, 68719476767ULL,
+        137438953481ULL, 274877906951ULL, 549755813911ULL, 1099511627791ULL, 2199023255579ULL, 4398046511119ULL,
+        8796093022237ULL, 17592186044423ULL, 35184372088891ULL, 70368744177679ULL, 140737488355333ULL,
+        281474976710677ULL, 562949953421381ULL, 1125899906842679ULL, 2251799813685269ULL, 4503599627370517ULL,
+        9007199254740997ULL, 18014398509482143ULL, 36028797018963971ULL, 72057594037928017ULL,
+        144115188075855881ULL, 288230376151711813ULL, 576460752303423619ULL, 1152921504606847009ULL,
+        2305843009213693967ULL, 4611686018427388039ULL, 9223372036854775837ULL};
+};
@@ -0,0 +1,301 @@
+#pragma once
+#include "vectorIterator.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <fcntl.h>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+
+enum class mmap_mode {
+    read_only,   // existing file, mapped PROT_READ, writing through operator[] faults
+    read_write,  // existing file, may grow
+    create       // new or truncated file
+};
+
+// vector of records whose storage is a shared mapping of a file: opening is O(1) and pages are read in as they
+// are touched; the file is grown ahead of the size with ftruncate + mremap, always by whole records, and cut back
+// to size() on sync() and close(), so it can be reopened after either (Linux only, mremap is not POSIX)
+template <typename T>
+class mmap_vector {
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "mmap_vector elements are stored as raw bytes");
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using iterator = vectorIterator<T>;
+    using const_iterator = vectorIterator<const T>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    mmap_vector() noexcept = default;
+
+    explicit mmap_vector(const char* path, mmap_mode mode = mmap_mode::read_only) : m_mode(mode) {
+        int flags = mode == mmap_mode::read_only ? O_RDONLY : O_RDWR;
+        if (mode == mmap_mode::create)
+            flags |= O_CREAT | O_TRUNC;
+        m_fd = ::open(path, flags | O_CLOEXEC, 0644);
+        if (m_fd < 0)
+            throw std::system_error(errno, std::generic_category(), path);
+        struct stat st;
+        if (::fstat(m_fd, &st) != 0) {
+            int err = errno;
+            ::close(m_fd);
+            throw std::system_error(err, std::generic_category(), path);
+        }
+        // a trailing partial record would be cut off by close(), so the file is refused instead
+        if (static_cast<size_type>(st.st_size) % sizeof(T) != 0) {
+            ::close(m_fd);
+            throw std::system_error(EINVAL, std::generic_category(), path);
+        }
+        m_size = static_cast<size_type>(st.st_size) / sizeof(T);
+        m_capacity = m_size;
+        if (m_size != 0) {
+            try {
+                map(m_size * sizeof(T));
+            } catch (...) {
+                ::close(m_fd);
+                throw;
+            }
+        }
+    }
+
+    mmap_vector(const mmap_vector&) = delete;
+    mmap_vector& operator=(const mmap_vector&) = delete;
+
+    mmap_vector(mmap_vector&& other) noexcept : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)), m_capacity(std::exchange(other.m_capacity, 0)), m_mapped(std::exchange(other.m_mapped, 0)), m_fd(std::exchange(other.m_fd, -1)), m_mode(other.m_mode) {}
+
+    mmap_vector& operator=(mmap_vector&& other) noexcept {
+        if (this != &other) {
+            close_quietly();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+            m_capacity = std::exchange(other.m_capacity, 0);
+            m_mapped = std::exchange(other.m_mapped, 0);
+            m_fd = std::exchange(other.m_fd, -1);
+            m_mode = other.m_mode;
+        }
+        return *this;
+    }
+
+    ~mmap_vector() noexcept {
+        close_quietly();
+    }
+
+    // unmaps and, when writable, cuts the file back to exactly size() elements; everything is released even
+    // when that cut fails, the failure is thrown afterwards
+    void close() {
+        int error = 0;
+        if (m_data != nullptr)
+            ::munmap(m_data, m_mapped);
+        if (m_fd >= 0) {
+            if (m_mode != mmap_mode::read_only && ::ftruncate(m_fd, static_cast<off_t>(m_size * sizeof(T))) != 0)
+                error = errno;
+            ::close(m_fd);
+        }
+        m_data = nullptr;
+        m_size = 0;
+        m_capacity = 0;
+        m_mapped = 0;
+        m_fd = -1;
+        if (error != 0)
+            throw std::system_error(error, std::generic_category(), "ftruncate");
+    }
+
+    // cuts the file back to size() elements and writes dirty pages back, async only schedules the write; the
+    // file on disk then holds exactly the elements, and the next push grows it again
+    void sync(bool async = false) {
+        if (m_data == nullptr)
+            return;
+        if (m_mode != mmap_mode::read_only && m_capacity != m_size) {
+            if (::ftruncate(m_fd, static_cast<off_t>(m_size * sizeof(T))) != 0)
+                throw std::system_error(errno, std::generic_category(), "ftruncate");
+            m_capacity = m_size;
+        }
+        if (::msync(m_data, m_mapped, async ? MS_ASYNC : MS_SYNC) != 0)
+            throw std::system_error(errno, std::generic_category(), "msync");
+    }
+
+    void push_back(const_reference val) {
+        if (size() >= capacity())
+            reserve(std::max<size_type>(capacity() * 2, 1));
+        m_data[m_size++] = val;
+    }
+
+    template <typename... Args>
+    reference emplace_back(Args&&... args) {
+        if (size() >= capacity())
+            reserve(std::max<size_type>(capacity() * 2, 1));
+        return *::new (static_cast<void*>(m_data + m_size++)) T(std::forward<Args>(args)...);
+    }
+
+    void pop_back() {
+        --m_size;
+    }
+
+    void clear() noexcept {
+        m_size = 0;
+    }
+
+    // new elements are not written, those past the old end of the file read as zero (the file grows sparsely)
+    void resize(size_type count) {
+        reserve(count);
+        m_size = count;
+    }
+
+    // grows the file and the mapping to at least count elements: the mapping is rounded up to whole pages, the
+    // file only to the whole records that fit in them, so its length stays a multiple of sizeof(T)
+    void reserve(size_type count) {
+        if (count <= capacity())
+            return;
+        if (m_mode == mmap_mode::read_only || m_fd < 0)
+            throw std::logic_error{"mmap_vector is not writable"};
+        static const size_type page = static_cast<size_type>(::sysconf(_SC_PAGESIZE));
+        size_type bytes = (count * sizeof(T) + page - 1) / page * page;
+        size_type new_capacity = bytes / sizeof(T);
+        if (::ftruncate(m_fd, static_cast<off_t>(new_capacity * sizeof(T))) != 0)
+            throw std::system_error(errno, std::generic_category(), "ftruncate");
+        if (m_data == nullptr) {
+            map(bytes);
+        } else if (bytes > m_mapped) {
+            void* moved = ::mremap(m_data, m_mapped, bytes, MREMAP_MAYMOVE);
+            if (moved == MAP_FAILED)
+                throw std::system_error(errno, std::generic_category(), "mremap");
+            m_data = static_cast<T*>(moved);
+            m_mapped = bytes;
+        }
+        m_capacity = new_capacity;
+    }
+
+    [[nodiscard]] constexpr reference operator[](size_type index) {
+        return m_data[index];
+    }
+    [[nodiscard]] constexpr const_reference operator[](size_type index) const {
+        return m_data[index];
+    }
+
+    [[nodiscard]] constexpr reference at(size_type index) {
+        if (index >= m_size)
+            throw std::out_of_range{"mmap_vector index out of range!"};
+        return m_data[index];
+    }
+    [[nodiscard]] constexpr const_reference at(size_type index) const {
+        if (index >= m_size)
+            throw std::out_of_range{"mmap_vector index out of range!"};
+        return m_data[index];
+    }
+
+    [[nodiscard]] constexpr reference front() {
+        return m_data[0];
+    }
+    [[nodiscard]] constexpr const_reference front() const {
+        return m_data[0];
+    }
+
+    [[nodiscard]] constexpr reference back() {
+        return m_data[size() - 1];
+    }
+    [[nodiscard]] constexpr const_reference back() const {
+        return m_data[size() - 1];
+    }
+
+    [[nodiscard]] constexpr size_type size() const noexcept {
+        return m_size;
+    }
+
+    [[nodiscard]] constexpr size_type capacity() const noexcept {
+        return m_capacity;
+    }
+
+    [[nodiscard]] constexpr bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[nodiscard]] constexpr bool is_open() const noexcept {
+        return m_fd >= 0;
+    }
+
+    [[nodiscard]] constexpr pointer data() {
+        return m_data;
+    }
+
+    [[nodiscard]] constexpr const_pointer data() const {
+        return m_data;
+    }
+
+    [[nodiscard]] constexpr iterator begin() {
+        return iterator(m_data);
+    }
+    [[nodiscard]] constexpr const_iterator cbegin() const {
+        return const_iterator(m_data);
+    }
+    [[nodiscard]] constexpr const_iterator begin() const {
+        return cbegin();
+    }
+
+    [[nodiscard]] constexpr iterator end() {
+        return iterator(m_data + size());
+    }
+    [[nodiscard]] constexpr const_iterator cend() const {
+        return const_iterator(m_data + size());
+    }
+    [[nodiscard]] constexpr const_iterator end() const {
+        return cend();
+    }
+
+    [[nodiscard]] constexpr reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+    [[nodiscard]] constexpr const_reverse_iterator crbegin() const {
+        return const_reverse_iterator(cend());
+    }
+    [[nodiscard]] constexpr const_reverse_iterator rbegin() const {
+        return crbegin();
+    }
+
+    [[nodiscard]] constexpr reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+    [[nodiscard]] constexpr const_reverse_iterator crend() const {
+        return const_reverse_iterator(cbegin());
+    }
+    [[nodiscard]] constexpr const_reverse_iterator rend() const {
+        return crend();
+    }
+
+private:
+    // destructor and move assignment cannot report a failed ftruncate, call close() to see it
+    void close_quietly() noexcept {
+        try {
+            close();
+        } catch (const std::system_error&) {
+        }
+    }
+
+    void map(size_type bytes) {
+        int prot = m_mode == mmap_mode::read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+        void* ptr = ::mmap(nullptr, bytes, prot, MAP_SHARED, m_fd, 0);
+        if (ptr == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        m_data = static_cast<T*>(ptr);
+        m_mapped = bytes;
+    }
+
+    T* m_data = nullptr;
+    size_type m_size = 0;
+    size_type m_capacity = 0;
+    size_type m_mapped = 0; // length of the mapping in bytes, what munmap and mremap must be given
+    int m_fd = -1;
+    mmap_mode m_mode = mmap_mode::read_only;
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include "allocator_hooks.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+#include <type_traits>
+#include <unistd.h>
+
+// blocks of at least Threshold bytes are mapped straight from the kernel, so growing one is an mremap that
+// extends it in place or moves its page table entries instead of copying the bytes; smaller blocks come from
+// operator new (Linux only, mremap is not POSIX)
+template <typename T, std::size_t Threshold = std::size_t{1} << 20>
+class mremap_allocator {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = mremap_allocator<U, Threshold>;
+    };
+
+    constexpr mremap_allocator() noexcept = default;
+
+    template <typename U>
+    constexpr mremap_allocator(const mremap_allocator<U, Threshold>&) noexcept {}
+
+    [[nodiscard]] T* allocate(size_type n) {
+        if (!mapped(n))
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+        void* ptr = ::mmap(nullptr, map_size(n), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED)
+            throw std::bad_alloc{};
+        return static_cast<T*>(ptr);
+    }
+
+    // mapped blocks are whole pages, the tail of the last page is handed out too
+    [[nodiscard]] allocation_result<T*> allocate_at_least(size_type n) {
+        if (mapped(n))
+            n = map_size(n) / sizeof(T);
+        return {allocate(n), n};
+    }
+
+    void deallocate(T* ptr, size_type n) noexcept {
+        if (mapped(n))
+            ::munmap(ptr, map_size(n));
+        else
+            ::operator delete(ptr, std::align_val_t(alignof(T)));
+    }
+
+    [[nodiscard]] bool try_expand(T* ptr, size_type n, size_type new_n) noexcept {
+        if (!mapped(n) || !mapped(new_n))
+            return false;
+        if (map_size(n) == map_size(new_n))
+            return true;
+        return ::mremap(ptr, map_size(n), map_size(new_n), 0) != MAP_FAILED;
+    }
+
+    [[nodiscard]] T* reallocate(T* ptr, size_type n, size_type new_n) {
+        if (mapped(n) && mapped(new_n)) {
+            void* moved = ::mremap(ptr, map_size(n), map_size(new_n), MREMAP_MAYMOVE);
+            if (moved == MAP_FAILED)
+                throw std::bad_alloc{};
+            return static_cast<T*>(moved);
+        }
+        T* new_ptr = allocate(new_n);
+        std::memcpy(static_cast<void*>(new_ptr), ptr, std::min(n, new_n) * sizeof(T));
+        deallocate(ptr, n);
+        return new_ptr;
+    }
+
+    template <typename U>
+    [[nodiscard]] constexpr bool operator==(const mremap_allocator<U, Threshold>&) const noexcept {
+        return true;
+    }
+
+private:
+    [[nodiscard]] static bool mapped(size_type n) noexcept {
+        return n * sizeof(T) >= Threshold;
+    }
+
+    [[nodiscard]] static size_type map_size(size_type n) noexcept {
+        static const size_type page = static_cast<size_type>(::sysconf(_SC_PAGESIZE));
+        return (n * sizeof(T) + page - 1) / page * page;
+    }
+};
@@ -0,0 +1,327 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// fixed set of worker threads taking tasks from one queue, the parallel algorithms below share global()
+class thread_pool {
+public:
+    explicit thread_pool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+        m_workers.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i)
+            m_workers.emplace_back([this] { work(); });
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (std::thread& worker : m_workers)
+            worker.join();
+    }
+
+    [[nodiscard]] static thread_pool& global() {
+        static thread_pool pool;
+        return pool;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept {
+        return m_workers.size();
+    }
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard lock(m_mutex);
+            m_tasks.push(std::move(task));
+        }
+        m_wake.notify_one();
+    }
+
+private:
+    void work() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(m_mutex);
+                m_wake.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+                if (m_tasks.empty())
+                    return;
+                task = std::move(m_tasks.front());
+                m_tasks.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stop = false;
+};
+
+// grain is the smallest number of elements worth a task of its own, threads caps how many run at once
+// (0 = every worker of the pool plus the calling thread)
+struct parallel_options {
+    std::size_t grain = 1 << 14;
+    std::size_t threads = 0;
+    thread_pool* pool = nullptr;
+};
+
+// runs f(chunk_begin, chunk_end) over [0, count) split into chunks of at least grain elements; the calling thread
+// takes chunks too, so nested calls and a busy pool cannot deadlock; the first exception thrown is rethrown
+template <typename F>
+void parallel_chunks(std::size_t count, F f, const parallel_options& options = {}) {
+    if (count == 0)
+        return;
+    thread_pool& pool = options.pool != nullptr ? *options.pool : thread_pool::global();
+    std::size_t threads = options.threads != 0 ? options.threads : pool.size() + 1;
+    std::size_t grain = std::max<std::size_t>(options.grain, 1);
+    // a few chunks per thread so an uneven chunk does not leave the others idle
+    std::size_t chunk = std::max(grain, (count + threads * 4 - 1) / (threads * 4));
+    std::size_t chunks = (count + chunk - 1) / chunk;
+    if (chunks == 1 || threads == 1) {
+        f(std::size_t{0}, count);
+        return;
+    }
+
+    struct shared_state {
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> finished{0};
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<shared_state>();
+    auto run = [state, count, chunk, chunks, &f] {
+        std::size_t index;
+        while ((index = state->next.fetch_add(1)) < chunks) {
+            try {
+                f(index * chunk, std::min(count, (index + 1) * chunk));
+            } catch (...) {
+                std::lock_guard lock(state->mutex);
+                if (!state->error)
+                    state->error = std::current_exception();
+            }
+            if (state->finished.fetch_add(1) + 1 == chunks) {
+                std::lock_guard lock(state->mutex);
+                state->done.notify_all();
+            }
+        }
+    };
+    // helpers that start after every chunk is taken return at once and never touch f
+    for (std::size_t i = 1; i < std::min(threads, chunks); ++i)
+        pool.submit(run);
+    run();
+    std::unique_lock lock(state->mutex);
+    state->done.wait(lock, [&] { return state->finished.load() == chunks; });
+    if (state->error)
+        std::rethrow_exception(state->error);
+}
+
+template <std::random_access_iterator It, typename F>
+void parallel_for_each(It first, It last, F f, const parallel_options& options = {}) {
+    parallel_chunks(static_cast<std::size_t>(last - first), [&](std::size_t begin, std::size_t end) {
+        std::for_each(first + begin, first + end, f);
+    }, options);
+}
+
+template <std::random_access_iterator It, std::random_access_iterator Out, typename F>
+Out parallel_transform(It first, It last, Out out, F f, const parallel_options& options = {}) {
+    std::size_t count = static_cast<std::size_t>(last - first);
+    parallel_chunks(count, [&](std::size_t begin, std::size_t end) {
+        std::transform(first + begin, first + end, out + begin, f);
+    }, options);
+    return out + count;
+}
+
+// op must be associative, chunk results are combined left to right so it need not be commutative
+template <std::random_access_iterator It, typename T, typename Op = std::plus<>>
+[[nodiscard]] T parallel_reduce(It first, It last, T init, Op op = {}, const parallel_options& options = {}) {
+    std::size_t count = static_cast<std::size_t>(last - first);
+    std::mutex mutex;
+    std::vector<std::pair<std::size_t, T>> partials;
+    parallel_chunks(count, [&](std::size_t begin, std::size_t end) {
+        T acc = first[begin];
+        for (std::size_t i = begin + 1; i < end; ++i)
+            acc = op(std::move(acc), first[i]);
+        std::lock_guard lock(mutex);
+        partials.emplace_back(begin, std::move(acc));
+    }, options);
+    std::sort(partials.begin(), partials.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (auto& partial : partials)
+        init = op(std::move(init), std::move(partial.second));
+    return init;
+}
+
+// two passes: every chunk is reduced, the chunk totals are scanned on the calling thread, then every chunk is
+// scanned again starting from the total of the chunks before it
+template <std::random_access_iterator It, std::random_access_iterator Out, typename Op = std::plus<>>
+Out parallel_inclusive_scan(It first, It last, Out out, Op op = {}, const parallel_options& options = {}) {
+    using T = typename std::iterator_traits<It>::value_type;
+    std::size_t count = static_cast<std::size_t>(last - first);
+    if (count == 0)
+        return out;
+    std::mutex mutex;
+    std::vector<std::pair<std::size_t, T>> totals;
+    parallel_chunks(count, [&](std::size_t begin, std::size_t end) {
+        T acc = first[begin];
+        for (std::size_t i = begin + 1; i < end; ++i)
+            acc = op(std::move(acc), first[i]);
+        std::lock_guard lock(mutex);
+        totals.emplace_back(begin, std::move(acc));
+    }, options);
+    std::sort(totals.begin(), totals.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (std::size_t i = 1; i < totals.size(); ++i)
+        totals[i].second = op(totals[i - 1].second, totals[i].second);
+    // the same options split the range into the same chunks again
+    parallel_chunks(count, [&](std::size_t begin, std::size_t end) {
+        auto chunk = std::lower_bound(totals.begin(), totals.end(), begin, [](const auto& a, std::size_t b) { return a.first < b; });
+        if (chunk == totals.begin()) {
+            std::inclusive_scan(first + begin, first + end, out + begin, op);
+        } else {
+            std::inclusive_scan(first + begin, first + end, out + begin, op, std::prev(chunk)->second);
+        }
+    }, options);
+    return out + count;
+}
+
+// merge path split: how many of the first k outputs of merging a[0, n) with b[0, m) come from a, ties taken
+// from a first as std::merge does; found by binary search along the k-th anti-diagonal
+template <std::random_access_iterator A, std::random_access_iterator B, typename Comp>
+[[nodiscard]] std::size_t merge_path_split(A a, std::size_t n, B b, std::size_t m, std::size_t k, Comp& comp) {
+    std::size_t lo = k > m ? k - m : 0;
+    std::size_t hi = std::min(k, n);
+    while (lo < hi) {
+        std::size_t i = lo + (hi - lo) / 2;
+        std::size_t j = k - i;
+        if (j > 0 && i < n && !comp(b[j - 1], a[i])) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+// every chunk is sorted on its own, then neighbouring runs are merged pairwise, going back and forth between
+// the range and a buffer; a round is split by output position with merge_path_split, not by pair, so the last
+// rounds, down to the final merge of two halves, still run on every thread
+template <std::random_access_iterator It, typename Comp = std::less<>>
+void parallel_sort(It first, It last, Comp comp = {}, const parallel_options& options = {}) {
+    using T = std::iter_value_t<It>;
+    std::size_t count = static_cast<std::size_t>(last - first);
+    std::mutex mutex;
+    std::vector<std::size_t> bounds{count};
+    parallel_chunks(count, [&](std::size_t begin, std::size_t end) {
+        std::sort(first + begin, first + end, comp);
+        std::lock_guard lock(mutex);
+        bounds.push_back(begin);
+    }, options);
+    if (bounds.size() <= 2)
+        return;
+    std::sort(bounds.begin(), bounds.end());
+
+    std::allocator<T> alloc;
+    T* buffer = alloc.allocate(count);
+    // the parts of buffer holding live elements, so a throw destroys exactly those
+    std::vector<std::pair<std::size_t, std::size_t>> built;
+    // the output of a round is cut into pieces of grain elements; every piece start is placed in its pair with
+    // merge_path_split before any element is moved, since the merges move out of the elements the splits compare
+    std::size_t piece = std::max<std::size_t>(options.grain, 1);
+    std::size_t pieces = (count + piece - 1) / piece;
+    std::vector<std::size_t> splits(pieces + 1);
+    parallel_options piece_options = options;
+    piece_options.grain = 1;
+    auto merge_round = [&](auto src, auto dst) {
+        std::size_t last_bound = bounds.size() - 1;
+        auto pair_of = [&](std::size_t pos) {
+            std::size_t run = static_cast<std::size_t>(std::upper_bound(bounds.begin(), bounds.end(), pos) - bounds.begin()) - 1;
+            return std::min(run, last_bound - 1) / 2;
+        };
+        auto pair_bounds = [&](std::size_t pair) {
+            return std::array<std::size_t, 3>{bounds[2 * pair], bounds[std::min(2 * pair + 1, last_bound)], bounds[std::min(2 * pair + 2, last_bound)]};
+        };
+        parallel_chunks(pieces + 1, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t p = begin; p < end; ++p) {
+                std::size_t pos = std::min(p * piece, count);
+                auto [lo, mid, hi] = pair_bounds(pair_of(pos));
+                splits[p] = merge_path_split(src + lo, mid - lo, src + mid, hi - mid, pos - lo, comp);
+            }
+        }, piece_options);
+        parallel_chunks(pieces, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t p = begin; p < end; ++p) {
+                std::size_t pos = p * piece;
+                std::size_t piece_end = std::min(pos + piece, count);
+                for (std::size_t pair = pair_of(pos); pos < piece_end; ++pair) {
+                    auto [lo, mid, hi] = pair_bounds(pair);
+                    std::size_t stop = std::min(piece_end, hi);
+                    // at a pair boundary the split is 0 or the whole first run, which needs no comparison
+                    std::size_t i = pos == lo ? 0 : splits[p];
+                    std::size_t j = stop == hi ? mid - lo : splits[p + 1];
+                    std::merge(std::make_move_iterator(src + lo + i), std::make_move_iterator(src + lo + j),
+                               std::make_move_iterator(src + mid + (pos - lo - i)), std::make_move_iterator(src + mid + (stop - lo - j)),
+                               dst + pos, comp);
+                    pos = stop;
+                }
+            }
+        }, piece_options);
+        std::vector<std::size_t> merged;
+        merged.reserve(bounds.size() / 2 + 2);
+        for (std::size_t i = 0; i < bounds.size(); i += 2)
+            merged.push_back(bounds[i]);
+        if (merged.back() != count)
+            merged.push_back(count);
+        bounds = std::move(merged);
+    };
+    try {
+        parallel_chunks(count, [&](std::size_t begin, std::size_t end) {
+            std::uninitialized_move(first + begin, first + end, buffer + begin);
+            std::lock_guard lock(mutex);
+            built.emplace_back(begin, end);
+        }, options);
+        bool in_buffer = true;
+        while (bounds.size() > 2) {
+            if (in_buffer) {
+                merge_round(buffer, first);
+            } else {
+                merge_round(first, buffer);
+            }
+            in_buffer = !in_buffer;
+        }
+        if (in_buffer) {
+            parallel_chunks(count, [&](std::size_t begin, std::size_t end) {
+                std::move(buffer + begin, buffer + end, first + begin);
+            }, options);
+        }
+    } catch (...) {
+        for (auto [begin, end] : built)
+            std::destroy(buffer + begin, buffer + end);
+        alloc.deallocate(buffer, count);
+        throw;
+    }
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+        parallel_chunks(count, [&](std::size_t begin, std::size_t end) {
+            std::destroy(buffer + begin, buffer + end);
+        }, options);
+    }
+    alloc.deallocate(buffer, count);
+}
@@ -0,0 +1,186 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// fixed-size slots carved out of slabs of BlockCount slots, freed slots are kept on an intrusive free list
+// and handed out again before any new slab is touched; slabs are only returned to the system at exit
+template <std::size_t Size, std::size_t Align, std::size_t BlockCount>
+class node_pool {
+public:
+    static constexpr std::size_t slot_align = std::max(Align, alignof(void*));
+    static constexpr std::size_t slot_size = (std::max(Size, sizeof(void*)) + slot_align - 1) / slot_align * slot_align;
+
+    // never destroyed: containers with static storage may still give nodes back while statics are torn down
+    [[nodiscard]] static node_pool& instance() {
+        static node_pool* pool = new node_pool;
+        return *pool;
+    }
+
+    [[nodiscard]] void* allocate() {
+        std::lock_guard lock(m_mutex);
+        return pop();
+    }
+
+    void deallocate(void* ptr) noexcept {
+        std::lock_guard lock(m_mutex);
+        push(ptr);
+    }
+
+    // chain of count slots linked through their first word, one lock for the whole batch
+    [[nodiscard]] void* allocate_batch(std::size_t count) {
+        std::lock_guard lock(m_mutex);
+        free_slot* head = nullptr;
+        for (std::size_t i = 0; i < count; ++i) {
+            free_slot* slot = static_cast<free_slot*>(pop());
+            slot->next = head;
+            head = slot;
+        }
+        return head;
+    }
+
+    void deallocate_batch(void* head, void* tail) noexcept {
+        std::lock_guard lock(m_mutex);
+        static_cast<free_slot*>(tail)->next = m_free;
+        m_free = static_cast<free_slot*>(head);
+    }
+
+private:
+    struct free_slot {
+        free_slot* next;
+    };
+
+    node_pool() = default;
+
+    void* pop() {
+        if (m_free != nullptr)
+            return std::exchange(m_free, m_free->next);
+        if (m_cursor == m_end)
+            new_slab();
+        return std::exchange(m_cursor, m_cursor + slot_size);
+    }
+
+    void push(void* ptr) noexcept {
+        free_slot* slot = static_cast<free_slot*>(ptr);
+        slot->next = m_free;
+        m_free = slot;
+    }
+
+    void new_slab() {
+        m_cursor = static_cast<std::byte*>(::operator new(slot_size * BlockCount, std::align_val_t(slot_align)));
+        m_end = m_cursor + slot_size * BlockCount;
+    }
+
+    std::mutex m_mutex;
+    free_slot* m_free = nullptr;
+    std::byte* m_cursor = nullptr;
+    std::byte* m_end = nullptr;
+};
+
+// per thread stack of free slots in front of node_pool, refilled and drained half a block at a time
+// so a thread that only allocates and frees its own nodes touches the shared lock once per BlockCount / 2 nodes
+template <std::size_t Size, std::size_t Align, std::size_t BlockCount>
+class node_pool_cache {
+public:
+    using pool_type = node_pool<Size, Align, BlockCount>;
+    static constexpr std::size_t batch = std::max<std::size_t>(BlockCount / 2, 1);
+
+    [[nodiscard]] static node_pool_cache& instance() {
+        thread_local node_pool_cache cache;
+        return cache;
+    }
+
+    [[nodiscard]] void* allocate() {
+        if (m_free == nullptr) {
+            m_free = static_cast<free_slot*>(pool_type::instance().allocate_batch(batch));
+            m_count = batch;
+        }
+        --m_count;
+        return std::exchange(m_free, m_free->next);
+    }
+
+    void deallocate(void* ptr) noexcept {
+        free_slot* slot = static_cast<free_slot*>(ptr);
+        slot->next = m_free;
+        m_free = slot;
+        if (++m_count >= 2 * batch)
+            flush(batch);
+    }
+
+    ~node_pool_cache() {
+        flush(m_count);
+    }
+
+private:
+    struct free_slot {
+        free_slot* next;
+    };
+
+    void flush(std::size_t count) noexcept {
+        if (count == 0)
+            return;
+        free_slot* head = m_free;
+        free_slot* tail = head;
+        for (std::size_t i = 1; i < count; ++i)
+            tail = tail->next;
+        m_free = tail->next;
+        m_count -= count;
+        pool_type::instance().deallocate_batch(head, tail);
+    }
+
+    free_slot* m_free = nullptr;
+    std::size_t m_count = 0;
+};
+
+// stateless allocator for node based containers: single element allocations (list, forward_list and
+// unordered_set_v1 nodes after rebind_alloc) come from a pool shared by every pool_allocator of the same
+// node size, anything bigger goes to operator new; ThreadCache puts a node_pool_cache in front of the pool
+template <typename T, std::size_t BlockCount = 256, bool ThreadCache = false>
+class pool_allocator {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = pool_allocator<U, BlockCount, ThreadCache>;
+    };
+
+    constexpr pool_allocator() noexcept = default;
+
+    template <typename U>
+    constexpr pool_allocator(const pool_allocator<U, BlockCount, ThreadCache>&) noexcept {}
+
+    [[nodiscard]] T* allocate(size_type n) {
+        if (n == 1) {
+            if constexpr (ThreadCache)
+                return static_cast<T*>(node_pool_cache<sizeof(T), alignof(T), BlockCount>::instance().allocate());
+            else
+                return static_cast<T*>(node_pool<sizeof(T), alignof(T), BlockCount>::instance().allocate());
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    void deallocate(T* ptr, size_type n) noexcept {
+        if (n == 1) {
+            if constexpr (ThreadCache)
+                node_pool_cache<sizeof(T), alignof(T), BlockCount>::instance().deallocate(ptr);
+            else
+                node_pool<sizeof(T), alignof(T), BlockCount>::instance().deallocate(ptr);
+            return;
+        }
+        ::operator delete(ptr, std::align_val_t(alignof(T)));
+    }
+
+    template <typename U>
+    [[nodiscard]] constexpr bool operator==(const pool_allocator<U, BlockCount, ThreadCache>&) const noexcept {
+        return true;
+    }
+};
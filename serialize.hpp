@@ -0,0 +1,388 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+
+// binary format for containers of trivially copyable elements: a 32 byte serial_header followed by the raw
+// elements; files are only read back on a machine with the same byte order and element size, nothing is swapped
+
+struct serial_header {
+    static constexpr std::uint32_t magic_value = 0x52455343; // "CSER"
+    static constexpr std::uint16_t current_version = 1;
+
+    std::uint32_t magic;
+    std::uint16_t version;
+    std::uint8_t little_endian;
+    std::uint8_t reserved0;
+    std::uint32_t type_size;
+    std::uint32_t reserved1;
+    std::uint64_t count;
+    std::uint64_t checksum;
+};
+static_assert(sizeof(serial_header) == 32);
+
+// fnv-1a over 64 bit words instead of bytes, fast enough to run over the payload at memory bandwidth; bytes are
+// gathered into whole words across update calls so the result does not depend on how the payload was chunked
+class serial_checksum {
+public:
+    void update(const void* data, std::size_t bytes) noexcept {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        while (m_pending != 0 && bytes != 0) {
+            m_word[m_pending++] = *p++;
+            --bytes;
+            if (m_pending == 8)
+                flush_word();
+        }
+        for (; bytes >= 8; bytes -= 8, p += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, p, 8);
+            mix(word);
+        }
+        while (bytes-- != 0)
+            m_word[m_pending++] = *p++;
+    }
+
+    [[nodiscard]] std::uint64_t value() const noexcept {
+        std::uint64_t hash = m_hash;
+        for (std::size_t i = 0; i < m_pending; ++i)
+            hash = (hash ^ m_word[i]) * prime;
+        return hash;
+    }
+
+private:
+    static constexpr std::uint64_t prime = 0x100000001B3ULL;
+
+    void mix(std::uint64_t word) noexcept {
+        m_hash = (m_hash ^ word) * prime;
+    }
+
+    void flush_word() noexcept {
+        std::uint64_t word;
+        std::memcpy(&word, m_word, 8);
+        mix(word);
+        m_pending = 0;
+    }
+
+    std::uint64_t m_hash = 0xCBF29CE484222325ULL;
+    unsigned char m_word[8] = {};
+    std::size_t m_pending = 0;
+};
+
+// containers whose elements are one block of memory (vector, small_vector, array, mmap_vector)
+template <class C>
+concept contiguous_container = requires(C& c) {
+    { c.data() } -> std::convertible_to<const typename C::value_type*>;
+    { c.size() } -> std::convertible_to<std::size_t>;
+};
+
+// containers that can hand out count uninitialised slots at the end to read into
+template <class C>
+concept overwritable_container = contiguous_container<C> && requires(C& c, std::size_t n) { c.resize_for_overwrite(n); };
+
+// size of the staging buffer when a payload goes through one (deque, streaming)
+inline constexpr std::size_t serial_chunk_bytes = std::size_t{1} << 20;
+
+// low level I/O, every call loops until the whole range is transferred
+
+inline void serial_write(int fd, const void* data, std::size_t bytes) {
+    const char* p = static_cast<const char*>(data);
+    while (bytes != 0) {
+        ssize_t done = ::write(fd, p, bytes);
+        if (done < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::system_error(errno, std::generic_category(), "write");
+        }
+        p += done;
+        bytes -= static_cast<std::size_t>(done);
+    }
+}
+
+inline void serial_read(int fd, void* data, std::size_t bytes) {
+    char* p = static_cast<char*>(data);
+    while (bytes != 0) {
+        ssize_t done = ::read(fd, p, bytes);
+        if (done < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::system_error(errno, std::generic_category(), "read");
+        }
+        if (done == 0)
+            throw std::runtime_error{"serialized payload is truncated"};
+        p += done;
+        bytes -= static_cast<std::size_t>(done);
+    }
+}
+
+// bytes left from the current offset of a regular file, or the largest size_t when fd is a pipe or socket whose
+// length is not known up front
+[[nodiscard]] inline std::size_t serial_remaining(int fd) {
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+        throw std::system_error(errno, std::generic_category(), "fstat");
+    if (!S_ISREG(st.st_mode))
+        return std::numeric_limits<std::size_t>::max();
+    off_t pos = ::lseek(fd, 0, SEEK_CUR);
+    if (pos < 0)
+        throw std::system_error(errno, std::generic_category(), "lseek");
+    return pos < st.st_size ? static_cast<std::size_t>(st.st_size - pos) : 0;
+}
+
+// uninitialized staging storage for count elements, T need not be default constructible; elements are
+// only ever copied in and out with memcpy
+template <typename T>
+class serial_buffer {
+public:
+    explicit serial_buffer(std::size_t count) : m_data(std::allocator<T>{}.allocate(count)), m_count(count) {}
+
+    serial_buffer(const serial_buffer&) = delete;
+    serial_buffer& operator=(const serial_buffer&) = delete;
+
+    ~serial_buffer() noexcept {
+        std::allocator<T>{}.deallocate(m_data, m_count);
+    }
+
+    [[nodiscard]] T* data() const noexcept {
+        return m_data;
+    }
+
+private:
+    T* m_data;
+    std::size_t m_count;
+};
+
+template <typename T>
+[[nodiscard]] serial_header make_serial_header(std::uint64_t count, std::uint64_t checksum) noexcept {
+    serial_header header{};
+    header.magic = serial_header::magic_value;
+    header.version = serial_header::current_version;
+    header.little_endian = std::endian::native == std::endian::little;
+    header.type_size = sizeof(T);
+    header.count = count;
+    header.checksum = checksum;
+    return header;
+}
+
+template <typename T>
+void check_serial_header(const serial_header& header) {
+    if (header.magic != serial_header::magic_value || header.version != serial_header::current_version)
+        throw std::runtime_error{"not a serialized container"};
+    if (header.little_endian != (std::endian::native == std::endian::little))
+        throw std::runtime_error{"serialized container has the wrong byte order"};
+    if (header.type_size != sizeof(T))
+        throw std::runtime_error{"serialized element size does not match"};
+}
+
+// owns a file descriptor for the path based overloads
+class serial_file {
+public:
+    serial_file(const char* path, int flags) : m_fd(::open(path, flags | O_CLOEXEC, 0644)) {
+        if (m_fd < 0)
+            throw std::system_error(errno, std::generic_category(), path);
+    }
+
+    serial_file(const serial_file&) = delete;
+    serial_file& operator=(const serial_file&) = delete;
+
+    ~serial_file() noexcept {
+        ::close(m_fd);
+    }
+
+    [[nodiscard]] int fd() const noexcept {
+        return m_fd;
+    }
+
+private:
+    int m_fd;
+};
+
+// save: header, then the payload with one write for contiguous containers or chunk by chunk through a buffer
+
+template <class C>
+void save(const C& container, int fd) {
+    using T = typename C::value_type;
+    static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable elements can be saved as raw bytes");
+    std::size_t count = container.size();
+    serial_checksum checksum;
+    if constexpr (contiguous_container<const C>) {
+        checksum.update(container.data(), count * sizeof(T));
+        serial_header header = make_serial_header<T>(count, checksum.value());
+        serial_write(fd, &header, sizeof(header));
+        serial_write(fd, container.data(), count * sizeof(T));
+    } else {
+        for (std::size_t i = 0; i < count; ++i)
+            checksum.update(&container[i], sizeof(T));
+        serial_header header = make_serial_header<T>(count, checksum.value());
+        serial_write(fd, &header, sizeof(header));
+        constexpr std::size_t chunk = std::max<std::size_t>(serial_chunk_bytes / sizeof(T), 1);
+        serial_buffer<T> buffer(std::min(chunk, std::max<std::size_t>(count, 1)));
+        for (std::size_t i = 0; i < count;) {
+            std::size_t n = std::min(chunk, count - i);
+            for (std::size_t j = 0; j < n; ++j)
+                std::memcpy(static_cast<void*>(buffer.data() + j), &container[i + j], sizeof(T));
+            serial_write(fd, buffer.data(), n * sizeof(T));
+            i += n;
+        }
+    }
+}
+
+template <class C>
+void save(const C& container, const char* path) {
+    serial_file file(path, O_WRONLY | O_CREAT | O_TRUNC);
+    save(container, file.fd());
+}
+
+// streams the payload to f(std::span<const T>) at most chunk_elements at a time, memory use stays at one chunk
+template <typename T, typename F>
+void load_chunks(int fd, F f, std::size_t chunk_elements = std::max<std::size_t>(serial_chunk_bytes / sizeof(T), 1)) {
+    static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable elements can be loaded as raw bytes");
+    serial_header header;
+    serial_read(fd, &header, sizeof(header));
+    check_serial_header<T>(header);
+    serial_buffer<T> buffer(static_cast<std::size_t>(std::min<std::uint64_t>(chunk_elements, std::max<std::uint64_t>(header.count, 1))));
+    serial_checksum checksum;
+    for (std::uint64_t i = 0; i < header.count;) {
+        std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(chunk_elements, header.count - i));
+        serial_read(fd, buffer.data(), n * sizeof(T));
+        checksum.update(buffer.data(), n * sizeof(T));
+        f(std::span<const T>(buffer.data(), n));
+        i += n;
+    }
+    if (checksum.value() != header.checksum)
+        throw std::runtime_error{"serialized payload checksum mismatch"};
+}
+
+template <typename T, typename F>
+void load_chunks(const char* path, F f, std::size_t chunk_elements = std::max<std::size_t>(serial_chunk_bytes / sizeof(T), 1)) {
+    serial_file file(path, O_RDONLY);
+    load_chunks<T>(file.fd(), f, chunk_elements);
+}
+
+// load: the container is sized from the header and the payload read straight into it with one read; containers
+// that are not contiguous are refilled chunk by chunk; a fixed size container must already have the saved size
+
+template <class C>
+void load(C& container, int fd) {
+    using T = typename C::value_type;
+    if constexpr (contiguous_container<C>) {
+        static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable elements can be loaded as raw bytes");
+        serial_header header;
+        serial_read(fd, &header, sizeof(header));
+        check_serial_header<T>(header);
+        // a corrupt count must not size the container past what the file holds
+        if (header.count > serial_remaining(fd) / sizeof(T))
+            throw std::runtime_error{"serialized payload is truncated"};
+        std::size_t count = static_cast<std::size_t>(header.count);
+        if constexpr (overwritable_container<C>)
+            container.resize_for_overwrite(count);
+        else if (container.size() != count)
+            throw std::runtime_error{"serialized element count does not match"};
+        serial_read(fd, container.data(), count * sizeof(T));
+        serial_checksum checksum;
+        checksum.update(container.data(), count * sizeof(T));
+        if (checksum.value() != header.checksum)
+            throw std::runtime_error{"serialized payload checksum mismatch"};
+    } else {
+        container.clear();
+        load_chunks<T>(fd, [&container](std::span<const T> chunk) {
+            for (const T& val : chunk)
+                container.push_back(val);
+        });
+    }
+}
+
+template <class C>
+void load(C& container, const char* path) {
+    serial_file file(path, O_RDONLY);
+    load(container, file.fd());
+}
+
+// read only view of a saved file through a private mapping, opening it touches only the header page; the
+// checksum is only computed on verify() since that reads every page
+template <typename T>
+class serial_view {
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable elements can be viewed as raw bytes");
+    static_assert(alignof(T) <= sizeof(serial_header), "payload starts right after the header");
+    using value_type = T;
+    using size_type = std::size_t;
+
+    explicit serial_view(const char* path) {
+        serial_file file(path, O_RDONLY);
+        struct stat st;
+        if (::fstat(file.fd(), &st) != 0)
+            throw std::system_error(errno, std::generic_category(), path);
+        m_bytes = static_cast<std::size_t>(st.st_size);
+        if (m_bytes < sizeof(serial_header))
+            throw std::runtime_error{"not a serialized container"};
+        void* ptr = ::mmap(nullptr, m_bytes, PROT_READ, MAP_PRIVATE, file.fd(), 0);
+        if (ptr == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        m_map = ptr;
+        try {
+            check_serial_header<T>(header());
+            if (header().count > (m_bytes - sizeof(serial_header)) / sizeof(T))
+                throw std::runtime_error{"serialized payload is truncated"};
+        } catch (...) {
+            ::munmap(m_map, m_bytes);
+            throw;
+        }
+    }
+
+    serial_view(const serial_view&) = delete;
+    serial_view& operator=(const serial_view&) = delete;
+
+    serial_view(serial_view&& other) noexcept : m_map(std::exchange(other.m_map, nullptr)), m_bytes(std::exchange(other.m_bytes, 0)) {}
+
+    serial_view& operator=(serial_view&& other) noexcept {
+        std::swap(m_map, other.m_map);
+        std::swap(m_bytes, other.m_bytes);
+        return *this;
+    }
+
+    ~serial_view() noexcept {
+        if (m_map != nullptr)
+            ::munmap(m_map, m_bytes);
+    }
+
+    [[nodiscard]] const serial_header& header() const noexcept {
+        return *static_cast<const serial_header*>(m_map);
+    }
+
+    [[nodiscard]] std::span<const T> elements() const noexcept {
+        return std::span<const T>(reinterpret_cast<const T*>(static_cast<const char*>(m_map) + sizeof(serial_header)), size());
+    }
+
+    [[nodiscard]] size_type size() const noexcept {
+        return static_cast<size_type>(header().count);
+    }
+
+    [[nodiscard]] const T& operator[](size_type index) const noexcept {
+        return elements()[index];
+    }
+
+    [[nodiscard]] bool verify() const noexcept {
+        serial_checksum checksum;
+        checksum.update(elements().data(), size() * sizeof(T));
+        return checksum.value() == header().checksum;
+    }
+
+private:
+    void* m_map = nullptr;
+    std::size_t m_bytes = 0;
+};
@@ -0,0 +1,166 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#if defined(__SSE2__) && !defined(SIMD_SEARCH_PORTABLE)
+#include <immintrin.h>
+#endif
+
+// true when two values are equal exactly when their bytes are, so equality can be memcmp and searches can
+// compare whole registers; floating point is excluded (0.0 == -0.0, NaN != NaN), specialize for padding free
+// structs whose operator== compares every member
+template <typename T>
+struct is_bitwise_comparable : std::bool_constant<std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>> {};
+
+template <typename T>
+inline constexpr bool is_bitwise_comparable_v = is_bitwise_comparable<std::remove_cv_t<T>>::value;
+
+// compares one register of elements of Size bytes against a broadcast needle, the mask has Size bits per
+// matching element in element order
+
+#if defined(__SSE2__) && !defined(SIMD_SEARCH_PORTABLE)
+struct simd_block_sse2 {
+    using reg = __m128i;
+    static constexpr std::size_t bytes = 16;
+
+    template <std::size_t Size>
+    [[nodiscard]] static reg splat(const void* val) noexcept {
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, val, Size);
+        if constexpr (Size == 1)
+            return _mm_set1_epi8(static_cast<char>(bits));
+        else if constexpr (Size == 2)
+            return _mm_set1_epi16(static_cast<short>(bits));
+        else if constexpr (Size == 4)
+            return _mm_set1_epi32(static_cast<int>(bits));
+        else
+            return _mm_set1_epi64x(static_cast<long long>(bits));
+    }
+
+    template <std::size_t Size>
+    [[nodiscard]] static std::uint32_t match(const void* ptr, reg needle) noexcept {
+        reg data = _mm_loadu_si128(static_cast<const reg*>(ptr));
+        if constexpr (Size == 1)
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(data, needle)));
+        else if constexpr (Size == 2)
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi16(data, needle)));
+        else if constexpr (Size == 4)
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi32(data, needle)));
+        else {
+            // no 64 bit compare before SSE4.1: a lane matches when both of its 32 bit halves do
+            std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi32(data, needle)));
+            return ((mask & 0xFFu) == 0xFFu ? 0xFFu : 0u) | ((mask & 0xFF00u) == 0xFF00u ? 0xFF00u : 0u);
+        }
+    }
+};
+#endif
+
+#if defined(__AVX2__) && !defined(SIMD_SEARCH_PORTABLE)
+struct simd_block_avx2 {
+    using reg = __m256i;
+    static constexpr std::size_t bytes = 32;
+
+    template <std::size_t Size>
+    [[nodiscard]] static reg splat(const void* val) noexcept {
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, val, Size);
+        if constexpr (Size == 1)
+            return _mm256_set1_epi8(static_cast<char>(bits));
+        else if constexpr (Size == 2)
+            return _mm256_set1_epi16(static_cast<short>(bits));
+        else if constexpr (Size == 4)
+            return _mm256_set1_epi32(static_cast<int>(bits));
+        else
+            return _mm256_set1_epi64x(static_cast<long long>(bits));
+    }
+
+    template <std::size_t Size>
+    [[nodiscard]] static std::uint32_t match(const void* ptr, reg needle) noexcept {
+        reg data = _mm256_loadu_si256(static_cast<const reg*>(ptr));
+        reg eq;
+        if constexpr (Size == 1)
+            eq = _mm256_cmpeq_epi8(data, needle);
+        else if constexpr (Size == 2)
+            eq = _mm256_cmpeq_epi16(data, needle);
+        else if constexpr (Size == 4)
+            eq = _mm256_cmpeq_epi32(data, needle);
+        else
+            eq = _mm256_cmpeq_epi64(data, needle);
+        return static_cast<std::uint32_t>(_mm256_movemask_epi8(eq));
+    }
+};
+#endif
+
+#if defined(__AVX2__) && !defined(SIMD_SEARCH_PORTABLE)
+using simd_block = simd_block_avx2;
+#define SIMD_SEARCH_BLOCK 1
+#elif defined(__SSE2__) && !defined(SIMD_SEARCH_PORTABLE)
+using simd_block = simd_block_sse2;
+#define SIMD_SEARCH_BLOCK 1
+#endif
+
+template <typename T>
+inline constexpr bool simd_searchable_v = is_bitwise_comparable_v<T> && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+// kernels over count contiguous elements, plain loops when evaluated at compile time or when T cannot be
+// compared a register at a time
+
+template <typename T>
+[[nodiscard]] constexpr bool simd_equal(const T* lhs, const T* rhs, std::size_t count) {
+    if constexpr (is_bitwise_comparable_v<T>) {
+        if (!std::is_constant_evaluated())
+            return count == 0 || std::memcmp(lhs, rhs, count * sizeof(T)) == 0;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!(lhs[i] == rhs[i]))
+            return false;
+    }
+    return true;
+}
+
+// index of the first element equal to val, count when there is none
+template <typename T>
+[[nodiscard]] constexpr std::size_t simd_find(const T* data, std::size_t count, const T& val) {
+    std::size_t i = 0;
+#if defined(SIMD_SEARCH_BLOCK)
+    if constexpr (simd_searchable_v<T>) {
+        if (!std::is_constant_evaluated()) {
+            constexpr std::size_t lanes = simd_block::bytes / sizeof(T);
+            auto needle = simd_block::template splat<sizeof(T)>(&val);
+            for (; i + lanes <= count; i += lanes) {
+                if (std::uint32_t mask = simd_block::template match<sizeof(T)>(data + i, needle))
+                    return i + static_cast<std::size_t>(std::countr_zero(mask)) / sizeof(T);
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        if (data[i] == val)
+            return i;
+    }
+    return count;
+}
+
+template <typename T>
+[[nodiscard]] constexpr std::size_t simd_count(const T* data, std::size_t count, const T& val) {
+    std::size_t i = 0;
+    std::size_t matches = 0;
+#if defined(SIMD_SEARCH_BLOCK)
+    if constexpr (simd_searchable_v<T>) {
+        if (!std::is_constant_evaluated()) {
+            constexpr std::size_t lanes = simd_block::bytes / sizeof(T);
+            auto needle = simd_block::template splat<sizeof(T)>(&val);
+            for (; i + lanes <= count; i += lanes)
+                matches += static_cast<std::size_t>(std::popcount(simd_block::template match<sizeof(T)>(data + i, needle)));
+            matches /= sizeof(T);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        if (data[i] == val)
+            ++matches;
+    }
+    return matches;
+}
@@ -0,0 +1,200 @@
+#pragma once
+#include "vector.hpp"
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+// values packed densely in a vector, reached through stable handles: erase moves the last value into the hole
+// instead of shifting, and every slot keeps a generation so a handle to an erased value no longer resolves
+// live slots have an odd generation, free slots an even one; handle{} never resolves
+template <typename T, class Alloc = std::allocator<T>>
+class slot_map {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using allocator_type = Alloc;
+    using value_vector = vector<T, Alloc>;
+    using iterator = typename value_vector::iterator;
+    using const_iterator = typename value_vector::const_iterator;
+
+    struct handle {
+        std::uint32_t index = 0;
+        std::uint32_t generation = 0;
+
+        [[nodiscard]] constexpr bool operator==(const handle& other) const noexcept = default;
+    };
+
+    slot_map() = default;
+
+    explicit slot_map(const allocator_type& alloc) : m_values(alloc), m_owner(owner_allocator(alloc)), m_slots(slot_allocator(alloc)) {}
+
+    handle insert(const_reference val) {
+        return emplace(val);
+    }
+
+    handle insert(value_type&& val) {
+        return emplace(std::move(val));
+    }
+
+    template <typename... Args>
+    handle emplace(Args&&... args) {
+        std::uint32_t index = m_free != npos ? m_free : static_cast<std::uint32_t>(m_slots.size());
+        if (m_values.size() >= npos)
+            throw std::length_error{"slot_map is full"};
+        m_values.emplace_back(std::forward<Args>(args)...);
+        try {
+            m_owner.push_back(index);
+            if (index == m_slots.size())
+                m_slots.push_back(slot{0, 0});
+        } catch (...) {
+            // m_owner may have grown before m_slots threw
+            if (m_owner.size() == m_values.size())
+                m_owner.pop_back();
+            m_values.pop_back();
+            throw;
+        }
+        slot& s = m_slots[index];
+        if (index == m_free)
+            m_free = s.target;
+        s.target = static_cast<std::uint32_t>(m_values.size() - 1);
+        ++s.generation;
+        return handle{index, s.generation};
+    }
+
+    // the last value moves into the erased one's place, only its own handle stays valid
+    bool erase(handle h) {
+        if (!contains(h))
+            return false;
+        slot& s = m_slots[h.index];
+        std::uint32_t dense = s.target;
+        std::uint32_t last = static_cast<std::uint32_t>(m_values.size() - 1);
+        if (dense != last) {
+            m_values[dense] = std::move(m_values[last]);
+            m_owner[dense] = m_owner[last];
+            m_slots[m_owner[dense]].target = dense;
+        }
+        m_values.pop_back();
+        m_owner.pop_back();
+        ++s.generation;
+        s.target = m_free;
+        m_free = h.index;
+        return true;
+    }
+
+    [[nodiscard]] bool contains(handle h) const noexcept {
+        return h.index < m_slots.size() && (h.generation & 1) != 0 && m_slots[h.index].generation == h.generation;
+    }
+
+    [[nodiscard]] pointer find(handle h) noexcept {
+        return contains(h) ? &m_values[m_slots[h.index].target] : nullptr;
+    }
+
+    [[nodiscard]] const_pointer find(handle h) const noexcept {
+        return contains(h) ? &m_values[m_slots[h.index].target] : nullptr;
+    }
+
+    [[nodiscard]] reference at(handle h) {
+        if (!contains(h))
+            throw std::out_of_range{"slot_map handle is stale!"};
+        return m_values[m_slots[h.index].target];
+    }
+
+    [[nodiscard]] const_reference at(handle h) const {
+        if (!contains(h))
+            throw std::out_of_range{"slot_map handle is stale!"};
+        return m_values[m_slots[h.index].target];
+    }
+
+    // unchecked, h must be live
+    [[nodiscard]] reference operator[](handle h) noexcept {
+        return m_values[m_slots[h.index].target];
+    }
+
+    [[nodiscard]] const_reference operator[](handle h) const noexcept {
+        return m_values[m_slots[h.index].target];
+    }
+
+    // handle of the value at a position of the dense iteration order
+    [[nodiscard]] handle handle_at(size_type position) const noexcept {
+        std::uint32_t index = m_owner[position];
+        return handle{index, m_slots[index].generation};
+    }
+
+    void reserve(size_type count) {
+        m_values.reserve(count);
+        m_owner.reserve(count);
+        m_slots.reserve(count);
+    }
+
+    // every live slot is freed, handles handed out so far stop resolving
+    void clear() {
+        for (std::uint32_t index : m_owner) {
+            slot& s = m_slots[index];
+            ++s.generation;
+            s.target = m_free;
+            m_free = index;
+        }
+        m_values.clear();
+        m_owner.clear();
+    }
+
+    [[nodiscard]] size_type size() const noexcept {
+        return m_values.size();
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return m_values.empty();
+    }
+
+    [[nodiscard]] pointer data() noexcept {
+        return m_values.data();
+    }
+
+    [[nodiscard]] const_pointer data() const noexcept {
+        return m_values.data();
+    }
+
+    [[nodiscard]] iterator begin() noexcept {
+        return m_values.begin();
+    }
+    [[nodiscard]] const_iterator begin() const noexcept {
+        return m_values.begin();
+    }
+    [[nodiscard]] const_iterator cbegin() const noexcept {
+        return m_values.cbegin();
+    }
+
+    [[nodiscard]] iterator end() noexcept {
+        return m_values.end();
+    }
+    [[nodiscard]] const_iterator end() const noexcept {
+        return m_values.end();
+    }
+    [[nodiscard]] const_iterator cend() const noexcept {
+        return m_values.cend();
+    }
+
+private:
+    static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+
+    // target is the dense position of a live slot, or the next free slot of a free one
+    struct slot {
+        std::uint32_t target;
+        std::uint32_t generation;
+    };
+
+    using owner_allocator = typename std::allocator_traits<Alloc>::template rebind_alloc<std::uint32_t>;
+    using slot_allocator = typename std::allocator_traits<Alloc>::template rebind_alloc<slot>;
+
+    value_vector m_values;
+    vector<std::uint32_t, owner_allocator> m_owner; // slot index of every dense value
+    vector<slot, slot_allocator> m_slots;
+    std::uint32_t m_free = npos;
+};
@@ -0,0 +1,6 @@
+#pragma once
+#include "vector.hpp"
+
+// vector with room for N elements inside the object, the allocator is only used once it holds more than N
+template <typename T, std::size_t N, class Alloc = std::allocator<T>, class Growth = power_of_two_growth>
+using small_vector = vector<T, Alloc, Growth, N>;
@@ -0,0 +1,198 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#if defined(__SSE2__) && !defined(SWISS_GROUP_PORTABLE)
+#include <immintrin.h>
+#endif
+
+// control byte per slot: empty/deleted/sentinel have the top bit set, full slots store the low 7 bits of the hash
+struct swiss_ctrl {
+    using type = std::int8_t;
+    static constexpr type empty = -128;   // 0b10000000
+    static constexpr type deleted = -2;   // 0b11111110
+    static constexpr type sentinel = -1;  // 0b11111111
+
+    [[nodiscard]] static constexpr bool is_full(type ctrl) noexcept {
+        return ctrl >= 0;
+    }
+
+    [[nodiscard]] static constexpr bool is_empty_or_deleted(type ctrl) noexcept {
+        return ctrl < sentinel;
+    }
+
+    // shared by every table with capacity 0 so find/begin never need a null check
+    [[nodiscard]] static type* empty_group() noexcept {
+        static const std::array<type, 32> group = [] {
+            std::array<type, 32> g;
+            g.fill(empty);
+            g[0] = sentinel;
+            return g;
+        }();
+        return const_cast<type*>(group.data());
+    }
+};
+
+// one bit (or one byte when Shift == 3) per slot of a group
+template <typename UInt, int Width, int Shift>
+class swiss_bitmask {
+public:
+    constexpr explicit swiss_bitmask(UInt mask) noexcept : m_mask(mask) {}
+
+    [[nodiscard]] constexpr explicit operator bool() const noexcept {
+        return m_mask != 0;
+    }
+
+    [[nodiscard]] constexpr int lowest() const noexcept {
+        return std::countr_zero(m_mask) >> Shift;
+    }
+
+    [[nodiscard]] constexpr int trailing_zeros() const noexcept {
+        return std::countr_zero(m_mask) >> Shift;
+    }
+
+    [[nodiscard]] constexpr int leading_zeros() const noexcept {
+        constexpr int extra_bits = std::numeric_limits<UInt>::digits - Width * (1 << Shift);
+        if (m_mask == 0)
+            return Width;
+        return (std::countl_zero(static_cast<UInt>(m_mask << extra_bits)) + ((1 << Shift) - 1)) >> Shift;
+    }
+
+    constexpr swiss_bitmask& operator++() noexcept {
+        m_mask &= m_mask - 1;
+        return *this;
+    }
+
+    [[nodiscard]] constexpr int operator*() const noexcept {
+        return lowest();
+    }
+
+    [[nodiscard]] constexpr swiss_bitmask begin() const noexcept {
+        return *this;
+    }
+
+    [[nodiscard]] constexpr swiss_bitmask end() const noexcept {
+        return swiss_bitmask(0);
+    }
+
+    [[nodiscard]] constexpr bool operator==(const swiss_bitmask& other) const noexcept {
+        return m_mask == other.m_mask;
+    }
+
+    [[nodiscard]] constexpr bool operator!=(const swiss_bitmask& other) const noexcept {
+        return !(*this == other);
+    }
+
+private:
+    UInt m_mask;
+};
+
+// portable group: 8 control bytes matched at once with word arithmetic
+class swiss_group_portable {
+public:
+    static constexpr std::size_t width = 8;
+    using bitmask = swiss_bitmask<std::uint64_t, 8, 3>;
+
+    explicit swiss_group_portable(const swiss_ctrl::type* ctrl) noexcept {
+        std::memcpy(&m_ctrl, ctrl, sizeof(m_ctrl));
+        if constexpr (std::endian::native == std::endian::big)
+            m_ctrl = std::byteswap(m_ctrl);
+    }
+
+    // can report a false positive only for a byte following a true match, keys are compared anyway
+    [[nodiscard]] bitmask match(std::uint8_t h2) const noexcept {
+        std::uint64_t x = m_ctrl ^ (lsbs * h2);
+        return bitmask((x - lsbs) & ~x & msbs);
+    }
+
+    [[nodiscard]] bitmask match_empty() const noexcept {
+        return bitmask((m_ctrl & ~(m_ctrl << 6)) & msbs);
+    }
+
+    [[nodiscard]] bitmask match_empty_or_deleted() const noexcept {
+        return bitmask((m_ctrl & ~(m_ctrl << 7)) & msbs);
+    }
+
+    [[nodiscard]] std::size_t count_leading_empty_or_deleted() const noexcept {
+        constexpr std::uint64_t gaps = 0x00FEFEFEFEFEFEFEULL;
+        return (std::countr_zero(((~m_ctrl & (m_ctrl >> 7)) | gaps) + 1) + 7) >> 3;
+    }
+
+private:
+    static constexpr std::uint64_t msbs = 0x8080808080808080ULL;
+    static constexpr std::uint64_t lsbs = 0x0101010101010101ULL;
+    std::uint64_t m_ctrl;
+};
+
+#if defined(__SSE2__) && !defined(SWISS_GROUP_PORTABLE)
+// 16 control bytes per compare, empty = 0x80 and deleted = 0xFE are the only bytes below the sentinel
+class swiss_group_sse2 {
+public:
+    static constexpr std::size_t width = 16;
+    using bitmask = swiss_bitmask<std::uint32_t, 16, 0>;
+
+    explicit swiss_group_sse2(const swiss_ctrl::type* ctrl) noexcept : m_ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+    [[nodiscard]] bitmask match(std::uint8_t h2) const noexcept {
+        return bitmask(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(h2)), m_ctrl))));
+    }
+
+    [[nodiscard]] bitmask match_empty() const noexcept {
+        return bitmask(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(swiss_ctrl::empty), m_ctrl))));
+    }
+
+    [[nodiscard]] bitmask match_empty_or_deleted() const noexcept {
+        return bitmask(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(swiss_ctrl::sentinel), m_ctrl))));
+    }
+
+    [[nodiscard]] std::size_t count_leading_empty_or_deleted() const noexcept {
+        std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(swiss_ctrl::sentinel), m_ctrl)));
+        return std::countr_zero(mask + 1);
+    }
+
+private:
+    __m128i m_ctrl;
+};
+#endif
+
+#if defined(__AVX2__) && !defined(SWISS_GROUP_PORTABLE)
+// 32 control bytes per compare
+class swiss_group_avx2 {
+public:
+    static constexpr std::size_t width = 32;
+    using bitmask = swiss_bitmask<std::uint32_t, 32, 0>;
+
+    explicit swiss_group_avx2(const swiss_ctrl::type* ctrl) noexcept : m_ctrl(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ctrl))) {}
+
+    [[nodiscard]] bitmask match(std::uint8_t h2) const noexcept {
+        return bitmask(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_set1_epi8(static_cast<char>(h2)), m_ctrl))));
+    }
+
+    [[nodiscard]] bitmask match_empty() const noexcept {
+        return bitmask(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_set1_epi8(swiss_ctrl::empty), m_ctrl))));
+    }
+
+    [[nodiscard]] bitmask match_empty_or_deleted() const noexcept {
+        return bitmask(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(swiss_ctrl::sentinel), m_ctrl))));
+    }
+
+    [[nodiscard]] std::size_t count_leading_empty_or_deleted() const noexcept {
+        std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(swiss_ctrl::sentinel), m_ctrl)));
+        return std::countr_zero(mask + 1);
+    }
+
+private:
+    __m256i m_ctrl;
+};
+#endif
+
+// widest group the target supports, define SWISS_GROUP_PORTABLE to force the scalar one
+#if defined(__AVX2__) && !defined(SWISS_GROUP_PORTABLE)
+using swiss_group = swiss_group_avx2;
+#elif defined(__SSE2__) && !defined(SWISS_GROUP_PORTABLE)
+using swiss_group = swiss_group_sse2;
+#else
+using swiss_group = swiss_group_portable;
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// a type is trivially relocatable when moving it to a new address and ending the old object's lifetime
+// without running its destructor is the same as a memcpy of its bytes; containers use this to move whole
+// buffers with memcpy/memmove
+// specialize for your own types that hold no pointer into themselves (handles, pimpl classes, ...)
+template <typename T>
+struct is_trivially_relocatable : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+template <typename T, typename Deleter>
+struct is_trivially_relocatable<std::unique_ptr<T, Deleter>> : is_trivially_relocatable<Deleter> {};
+
+template <typename T>
+struct is_trivially_relocatable<std::shared_ptr<T>> : std::true_type {};
+
+template <typename T>
+struct is_trivially_relocatable<std::weak_ptr<T>> : std::true_type {};
+
+template <typename T1, typename T2>
+struct is_trivially_relocatable<std::pair<T1, T2>> : std::bool_constant<is_trivially_relocatable<T1>::value && is_trivially_relocatable<T2>::value> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<std::remove_cv_t<T>>::value;
@@ -1,10 +1,25 @@
 #pragma once
+#include "hash_policy.hpp"
+#include "unordered_set_v1Iterator.hpp"
 #include <bit>
 #include <cmath>
 #include <list>
 #include <memory>
 #include <vector>
-template <typename T, class Hash = std::hash<T>, class KeyEqual = std::equal_to<T>, class Allocator = std::allocator<T>>
+
+template <typename T, bool CacheHash>
+struct unordered_set_v1_node {
+    T val;
+};
+
+// full hash kept next to the key: bucket checks and rehash compare integers instead of calling Hash
+template <typename T>
+struct unordered_set_v1_node<T, true> {
+    T val;
+    std::size_t hash;
+};
+
+template <typename T, class Hash = std::hash<T>, class KeyEqual = std::equal_to<T>, class Allocator = std::allocator<T>, bool CacheHash = !is_fast_hash_v<Hash, T>, class BucketPolicy = power_of_two_bucket_policy<>>
 class unordered_set_v1 {
 public:
     // how allocator type works????
@@ -15,34 +30,73 @@ public:
     using hasher = Hash;
     using key_equal = KeyEqual;
     using allocator_type = Allocator;
+    using bucket_policy = BucketPolicy;
     using reference = T&;
     using const_reference = const T&;
-    using iterator = typename std::list<T, allocator_type>::iterator;
-    using const_iterator = typename std::list<T, allocator_type>::const_iterator;
-    // using node_type = std::list<T,m_alloc>::node_type;
+    using node_type_internal = unordered_set_v1_node<T, CacheHash>;
+    using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<node_type_internal>;
+    using list_type = std::list<node_type_internal, node_allocator>;
+    using iterator = unordered_set_v1Iterator<T, typename list_type::iterator>;
+    using const_iterator = unordered_set_v1Iterator<const T, typename list_type::const_iterator>;
+    static constexpr bool cache_hash = CacheHash;
+
+    // owns one extracted element; the node (and its cached hash) moves between sets by relinking, never reallocated
+    class node_type {
+    public:
+        using value_type = T;
+        using allocator_type = Allocator;
+
+        node_type() = default;
+        node_type(node_type&&) noexcept = default;
+        node_type& operator=(node_type&&) noexcept = default;
+
+        [[nodiscard]] bool empty() const noexcept {
+            return m_list.empty();
+        }
+
+        [[nodiscard]] explicit operator bool() const noexcept {
+            return !empty();
+        }
+
+        [[nodiscard]] value_type& value() const {
+            return const_cast<value_type&>(m_list.front().val);
+        }
+
+        [[nodiscard]] allocator_type get_allocator() const {
+            return allocator_type(m_list.get_allocator());
+        }
+
+    private:
+        friend class unordered_set_v1;
+
+        explicit node_type(const node_allocator& alloc) : m_list(alloc) {}
+
+        list_type m_list;
+    };
+
+    struct insert_return_type {
+        iterator position;
+        bool inserted;
+        node_type node;
+    };
 
     static constexpr size_type MIN_SIZE = sizeof(T) <= 8 ? 32 : sizeof(T) <= 16 ? 16
                                                             : sizeof(T) <= 16   ? 8
                                                                                 : 4;
 
-    unordered_set_v1() : m_list(allocator_type{}), m_vec(8, m_list.end()) {
+    unordered_set_v1() : m_alloc(allocator_type{}), m_list(node_allocator(m_alloc)), m_vec(bucket_policy::bucket_count(8), m_list.end()) {
     }
 
     iterator erase(iterator pos)
         requires(!std::same_as<iterator, const_iterator>)
     {
-        size_type bucket = Hash{}(*pos) % m_vec.size();
-        if (m_vec[bucket] == pos)
-            ++m_vec[bucket];
-
-        return m_list.erase(pos);
+        return erase(const_iterator(pos));
     }
 
     iterator erase(const_iterator pos) {
-        size_type bucket = Hash{}(*pos) % m_vec.size();
-        if (m_vec[bucket] == pos)
-            ++m_vec[bucket];
-        return m_list.erase(pos);
+        migrate_buckets(m_rehash_step);
+        unlink_bucket_head(pos.base());
+        return iterator(m_list.erase(pos.base()));
     }
 
     size_type erase(const_reference val) {
@@ -53,6 +107,16 @@ public:
         return 1;
     }
 
+    template <typename K>
+        requires(transparent_hash<Hash, KeyEqual> && !std::convertible_to<K, iterator> && !std::convertible_to<K, const_iterator>)
+    size_type erase(K&& key) {
+        iterator it = find(key);
+        if (it == end())
+            return 0;
+        erase(it);
+        return 1;
+    }
+
     iterator erase(iterator first, iterator last) {
         iterator final = end();
         while (first != last)
@@ -69,88 +133,160 @@ public:
     }
 
     size_type count(const_reference val) const {
-        size_type bucket = Hash{}(val) % m_vec.size();
-        iterator curr = m_vec[bucket];
-        size_type acc = 0;
-        while (curr != m_list.end() && Hash{}(*curr) % m_vec.size() == bucket) {
-            if (*curr++ == val)
-                ++acc;
-        }
-        return acc;
+        return find_node(Hash{}(val), val) != m_list.end() ? 1 : 0;
     }
 
     iterator find(const_reference val) {
-        size_type bucket = Hash{}(val) % m_vec.size();
-        iterator curr = m_vec[bucket];
-        while (curr != m_list.end() && Hash{}(*curr) % m_vec.size() == bucket) {
-            if (*curr++ == val)
-                return --curr;
-        }
-        return end();
+        return iterator(find_node(Hash{}(val), val));
     }
 
     const_iterator find(const_reference val) const {
-        size_type bucket = Hash{}(val) % m_vec.size();
-        iterator curr = m_vec[bucket];
-        while (curr != m_list.end() && Hash{}(*curr) % m_vec.size() == bucket) {
-            if (*curr++ == val)
-                return --curr;
-        }
-        return cend();
+        return const_iterator(find_node(Hash{}(val), val));
     }
 
     [[nodiscard]] bool contains(const_reference val) const {
         return find(val) != end();
     }
 
+    template <typename K>
+        requires transparent_hash<Hash, KeyEqual>
+    size_type count(const K& key) const {
+        return find_node(Hash{}(key), key) != m_list.end() ? 1 : 0;
+    }
+
+    template <typename K>
+        requires transparent_hash<Hash, KeyEqual>
+    iterator find(const K& key) {
+        return iterator(find_node(Hash{}(key), key));
+    }
+
+    template <typename K>
+        requires transparent_hash<Hash, KeyEqual>
+    const_iterator find(const K& key) const {
+        return const_iterator(find_node(Hash{}(key), key));
+    }
+
+    template <typename K>
+        requires transparent_hash<Hash, KeyEqual>
+    [[nodiscard]] bool contains(const K& key) const {
+        return find(key) != end();
+    }
+
     // insert hing
     template <typename... Args>
     void emplace(Args&&... args) {
         insert(value_type(std::forward<Args>(args)...));
     }
 
+    // sized ranges reserve once (duplicates may leave the table a little oversized), then keys are
+    // hashed a batch at a time and their buckets prefetched before the batch is probed
     template <typename It>
     void insert(It first, It last) {
-        while (first != last)
-            insert(*first++);
+        if constexpr (std::derived_from<typename std::iterator_traits<It>::iterator_category, std::forward_iterator_tag>) {
+            reserve(size() + std::distance(first, last));
+            size_type hashes[insert_batch];
+            while (first != last) {
+                It batch = first;
+                size_type count = 0;
+                for (; count < insert_batch && first != last; ++count, ++first) {
+                    hashes[count] = Hash{}(*first);
+                    prefetch_read(&m_vec[bucket_index(hashes[count])]);
+                }
+                for (size_type i = 0; i < count; ++i) {
+                    typename list_type::iterator head = m_vec[bucket_index(hashes[i])];
+                    if (head != m_list.end())
+                        prefetch_read(&*head);
+                }
+                for (size_type i = 0; i < count; ++i, ++batch)
+                    insert_hashed(hashes[i], *batch);
+            }
+        } else {
+            while (first != last)
+                insert(*first++);
+        }
     }
 
     void insert(std::initializer_list<value_type> ilist) {
-        for (const_reference val : ilist)
-            insert(val);
+        insert(ilist.begin(), ilist.end());
     }
 
     // when rehashing splice the nodes
     constexpr std::pair<iterator, bool> insert(const_reference val) {
-        if (contains(val))
-            return std::make_pair(find(val), false);
-        if (size() >= Max_load_factor * m_vec.size()) {
-            rehash(m_vec.size() * 2);
-        }
-        // rehash first??
-        size_type bucket = Hash{}(val) % m_vec.size();
-        return std::make_pair(m_vec[bucket] = m_list.insert(m_vec[bucket], val), true);
+        return insert_hashed(Hash{}(val), val);
     }
 
     constexpr std::pair<iterator, bool> insert(value_type&& val) {
-        if (contains(val))
-            return std::make_pair(find(val), false);
+        return insert_hashed(Hash{}(val), std::move(val));
+    }
+
+    node_type extract(const_iterator pos) {
+        migrate_buckets(m_rehash_step);
+        unlink_bucket_head(pos.base());
+        node_type node(m_list.get_allocator());
+        node.m_list.splice(node.m_list.end(), m_list, pos.base());
+        return node;
+    }
+
+    node_type extract(const_reference val) {
+        const_iterator it = find(val);
+        if (it == cend())
+            return node_type{};
+        return extract(it);
+    }
+
+    // on a duplicate the node is handed back untouched in insert_return_type::node
+    insert_return_type insert(node_type&& node) {
+        if (node.empty())
+            return insert_return_type{end(), false, node_type{}};
+        typename list_type::iterator it = node.m_list.begin();
+        size_type hash = hash_of(*it);
+        migrate_buckets(m_rehash_step);
+        typename list_type::iterator found = find_node(hash, it->val);
+        if (found != m_list.end())
+            return insert_return_type{iterator(found), false, std::move(node)};
         if (size() >= Max_load_factor * m_vec.size()) {
-            rehash(m_vec.size() * 2);
+            grow();
+        }
+        typename list_type::iterator& head = bucket_head(bucket_of(hash));
+        m_list.splice(head, node.m_list, it);
+        head = it;
+        return insert_return_type{iterator(it), true, node_type{}};
+    }
+
+    // moves every node whose key is not already here out of source; allocators must compare equal
+    void merge(unordered_set_v1& source) {
+        if (&source == this)
+            return;
+        typename list_type::iterator it = source.m_list.begin();
+        while (it != source.m_list.end()) {
+            typename list_type::iterator next = std::next(it);
+            size_type hash = hash_of(*it);
+            if (find_node(hash, it->val) == m_list.end()) {
+                source.unlink_bucket_head(it);
+                if (size() >= Max_load_factor * m_vec.size()) {
+                    grow();
+                }
+                typename list_type::iterator& head = bucket_head(bucket_of(hash));
+                m_list.splice(head, source.m_list, it);
+                head = it;
+            }
+            it = next;
         }
-        size_type bucket = Hash{}(val) % m_vec.size();
-        m_vec[bucket] = m_list.insert(m_vec[bucket], std::move(val));
+    }
+
+    void merge(unordered_set_v1&& source) {
+        merge(source);
     }
 
     void rehash(size_type count) {
-        size_type size = std::bit_ceil(count);
-        std::list<T, allocator_type> list;
-        std::vector<typename std::list<T, allocator_type>::iterator> vec(size, m_list.end());
+        size_type size = bucket_policy::bucket_count(count);
+        list_type list(m_list.get_allocator());
+        std::vector<typename list_type::iterator> vec(size, m_list.end());
         auto it = m_list.begin();
         auto next = it;
         while (it != m_list.end()) {
             ++next;
-            size_type bucket = Hash{}(*it) % vec.size();
+            size_type bucket = bucket_policy::index(hash_of(*it), vec.size());
             if (vec[bucket] == m_list.end())
                 vec[bucket] = list.end();
 
@@ -160,6 +296,8 @@ public:
         }
         m_list = std::move(list);
         m_vec = std::move(vec);
+        std::vector<typename list_type::iterator>().swap(m_old_vec);
+        m_migrated = 0;
     }
 
     [[nodiscard]] constexpr allocator_type get_allocator() const noexcept {
@@ -175,7 +313,7 @@ public:
     }
 
     [[nodiscard]] constexpr float load_factor() const noexcept {
-        return size() / static_cast<float>(m_bucketCount);
+        return size() / static_cast<float>(bucket_count());
     }
 
     [[nodiscard]] constexpr float max_load_factor() const noexcept {
@@ -186,8 +324,23 @@ public:
         Max_load_factor = ml;
     }
 
+    // 0 (the default) rebuilds every bucket inside the insert that crosses the load factor, n > 0 keeps the
+    // old buckets alive and moves n of them per insert/erase so no single operation pays for the whole rehash
+    constexpr void incremental_rehash(size_type buckets_per_op) noexcept {
+        m_rehash_step = buckets_per_op;
+    }
+
+    [[nodiscard]] constexpr size_type incremental_rehash() const noexcept {
+        return m_rehash_step;
+    }
+
+    [[nodiscard]] constexpr bool rehashing() const noexcept {
+        return !m_old_vec.empty();
+    }
+
     void reserve(size_type count) {
-        rehash(std::ceil(count / max_load_factor()));
+        if (count > max_load_factor() * bucket_count())
+            rehash(std::ceil(count / max_load_factor()));
     }
 
     [[nodiscard]] hasher hash_function() const {
@@ -199,42 +352,174 @@ public:
     }
 
     [[nodiscard]] constexpr size_type bucket_count() const noexcept {
-        return m_bucketCount;
+        return m_vec.size();
     }
 
     void clear() {
         m_list.clear();
-        m_vec = std::vector<typename std::list<T, allocator_type>::iterator>(8, m_list.end());
+        m_vec = std::vector<typename list_type::iterator>(bucket_policy::bucket_count(8), m_list.end());
+        std::vector<typename list_type::iterator>().swap(m_old_vec);
+        m_migrated = 0;
     }
 
     [[nodiscard]] constexpr iterator begin() {
-        return m_list.begin();
+        return iterator(m_list.begin());
     }
 
     [[nodiscard]] constexpr const_iterator cbegin() const {
-        return m_list.cbegin();
+        return const_iterator(m_list.cbegin());
     }
 
     [[nodiscard]] constexpr const_iterator begin() const {
-        return m_list.cbegin();
+        return const_iterator(m_list.cbegin());
     }
 
     [[nodiscard]] constexpr iterator end() {
-        return m_list.end();
+        return iterator(m_list.end());
     }
 
     [[nodiscard]] constexpr const_iterator cend() const {
-        return m_list.cend();
+        return const_iterator(m_list.cend());
     }
 
     [[nodiscard]] constexpr const_iterator end() const {
-        return m_list.cend();
+        return const_iterator(m_list.cend());
     }
 
 private:
+    static constexpr size_type insert_batch = 16;
+
+    // a run of nodes is either an unmigrated bucket of m_old_vec or a bucket of m_vec
+    struct bucket_id {
+        bool old;
+        size_type index;
+
+        [[nodiscard]] constexpr bool operator==(const bucket_id&) const noexcept = default;
+    };
+
+    [[nodiscard]] static constexpr size_type hash_of(const node_type_internal& node) {
+        if constexpr (CacheHash)
+            return node.hash;
+        else
+            return Hash{}(node.val);
+    }
+
+    [[nodiscard]] constexpr size_type bucket_index(size_type hash) const noexcept {
+        return bucket_policy::index(hash, m_vec.size());
+    }
+
+    // old buckets below m_migrated have already been moved over to m_vec
+    [[nodiscard]] constexpr bucket_id bucket_of(size_type hash) const noexcept {
+        if (!m_old_vec.empty()) {
+            size_type old = bucket_policy::index(hash, m_old_vec.size());
+            if (old >= m_migrated)
+                return bucket_id{true, old};
+        }
+        return bucket_id{false, bucket_index(hash)};
+    }
+
+    [[nodiscard]] typename list_type::iterator& bucket_head(bucket_id bucket) {
+        return bucket.old ? m_old_vec[bucket.index] : m_vec[bucket.index];
+    }
+
+    [[nodiscard]] typename list_type::iterator bucket_head(bucket_id bucket) const {
+        return bucket.old ? m_old_vec[bucket.index] : m_vec[bucket.index];
+    }
+
+    // with a cached hash most mismatches are rejected without touching the key
+    template <typename K>
+    [[nodiscard]] static constexpr bool node_matches(const node_type_internal& node, [[maybe_unused]] size_type hash, const K& key) {
+        if constexpr (CacheHash)
+            return node.hash == hash && KeyEqual{}(node.val, key);
+        else
+            return KeyEqual{}(node.val, key);
+    }
+
+    // one probe per key: a miss falls straight through to the insert
+    template <typename V>
+    std::pair<iterator, bool> insert_hashed(size_type hash, V&& val) {
+        migrate_buckets(m_rehash_step);
+        typename list_type::iterator found = find_node(hash, val);
+        if (found != m_list.end())
+            return std::make_pair(iterator(found), false);
+        if (size() >= Max_load_factor * m_vec.size()) {
+            grow();
+        }
+        typename list_type::iterator& head = bucket_head(bucket_of(hash));
+        return std::make_pair(iterator(head = emplace_node(head, hash, std::forward<V>(val))), true);
+    }
+
+    void grow() {
+        if (m_rehash_step == 0) {
+            rehash(m_vec.size() * 2);
+            return;
+        }
+        // the previous rehash did not finish before the new buckets filled up
+        migrate_buckets(m_old_vec.size());
+        m_old_vec = std::move(m_vec);
+        m_vec.assign(bucket_policy::bucket_count(m_old_vec.size() * 2), m_list.end());
+        m_migrated = 0;
+    }
+
+    // moves whole old buckets to the front of their new bucket, nodes never leave m_list so iterators stay valid
+    void migrate_buckets(size_type count) {
+        for (; count > 0 && !m_old_vec.empty(); --count) {
+            size_type old = m_migrated;
+            typename list_type::iterator curr = m_old_vec[old];
+            while (curr != m_list.end() && bucket_policy::index(hash_of(*curr), m_old_vec.size()) == old) {
+                typename list_type::iterator next = std::next(curr);
+                typename list_type::iterator& head = m_vec[bucket_index(hash_of(*curr))];
+                m_list.splice(head, m_list, curr);
+                head = curr;
+                curr = next;
+            }
+            if (++m_migrated == m_old_vec.size()) {
+                std::vector<typename list_type::iterator>().swap(m_old_vec);
+                m_migrated = 0;
+            }
+        }
+    }
+
+    template <typename V>
+    typename list_type::iterator emplace_node(typename list_type::const_iterator pos, [[maybe_unused]] size_type hash, V&& val) {
+        if constexpr (CacheHash)
+            return m_list.emplace(pos, std::forward<V>(val), hash);
+        else
+            return m_list.emplace(pos, std::forward<V>(val));
+    }
+
+    // nodes of a bucket are contiguous in m_list starting at its head
+    template <typename K>
+    [[nodiscard]] typename list_type::iterator find_node(size_type hash, const K& key) const {
+        bucket_id bucket = bucket_of(hash);
+        typename list_type::iterator curr = bucket_head(bucket);
+        typename list_type::iterator last = const_cast<list_type&>(m_list).end();
+        while (curr != last && bucket_of(hash_of(*curr)) == bucket) {
+            if (node_matches(*curr, hash, key))
+                return curr;
+            ++curr;
+        }
+        return last;
+    }
+
+    // called before pos leaves the list so its bucket never points at a dead node
+    void unlink_bucket_head(typename list_type::const_iterator pos) {
+        bucket_id bucket = bucket_of(hash_of(*pos));
+        typename list_type::iterator& head = bucket_head(bucket);
+        if (head != pos)
+            return;
+        typename list_type::iterator next = std::next(head);
+        if (next != m_list.end() && bucket_of(hash_of(*next)) == bucket)
+            head = next;
+        else
+            head = m_list.end();
+    }
+
     float Max_load_factor = 0.8f;
-    size_type m_bucketCount;
     [[no_unique_address]] allocator_type m_alloc;
-    std::list<T, allocator_type> m_list;
-    std::vector<typename std::list<T, allocator_type>::iterator> m_vec;
+    list_type m_list;
+    std::vector<typename list_type::iterator> m_vec;
+    std::vector<typename list_type::iterator> m_old_vec;
+    size_type m_migrated = 0;
+    size_type m_rehash_step = 0;
 };
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+#include <concepts>
+#include <iterator>
+#include <type_traits>
+
+// walks the node list of unordered_set_v1 and hides the cached hash stored next to each key
+template <typename T, typename ListIt>
+class unordered_set_v1Iterator {
+public:
+    template <typename U, typename It>
+    friend class unordered_set_v1Iterator;
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = std::remove_const_t<T>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    unordered_set_v1Iterator() = default;
+
+    explicit unordered_set_v1Iterator(ListIt it) : m_it(it) {}
+
+    template <typename U, typename It>
+        requires std::convertible_to<It, ListIt>
+    unordered_set_v1Iterator(const unordered_set_v1Iterator<U, It>& other) : m_it(other.m_it) {}
+
+    [[nodiscard]] constexpr reference operator*() const {
+        return m_it->val;
+    }
+
+    [[nodiscard]] constexpr pointer operator->() const {
+        return &m_it->val;
+    }
+
+    constexpr unordered_set_v1Iterator& operator++() {
+        ++m_it;
+        return *this;
+    }
+
+    constexpr unordered_set_v1Iterator operator++(int) {
+        unordered_set_v1Iterator tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+
+    constexpr unordered_set_v1Iterator& operator--() {
+        --m_it;
+        return *this;
+    }
+
+    constexpr unordered_set_v1Iterator operator--(int) {
+        unordered_set_v1Iterator tmp = *this;
+        --(*this);
+        return tmp;
+    }
+
+    [[nodiscard]] constexpr bool operator==(const unordered_set_v1Iterator& other) const noexcept {
+        return m_it == other.m_it;
+    }
+
+    [[nodiscard]] constexpr bool operator!=(const unordered_set_v1Iterator& other) const noexcept {
+        return !(*this == other);
+    }
+
+    [[nodiscard]] constexpr ListIt base() const {
+        return m_it;
+    }
+
+private:
+    ListIt m_it;
+};
@@ -0,0 +1,455 @@
+#pragma once
+#include "hash_policy.hpp"
+#include "swiss_group.hpp"
+#include "unordered_set_v2Iterator.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+
+// open addressing set: one control byte per slot, probed a group at a time, elements stored inline in one slot array
+template <typename T, class Hash = std::hash<T>, class KeyEqual = std::equal_to<T>, class Allocator = std::allocator<T>>
+class unordered_set_v2 {
+public:
+    using key_type = T;
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = unordered_set_v2Iterator<T>;
+    using const_iterator = unordered_set_v2Iterator<T>;
+    using ctrl_type = swiss_ctrl::type;
+    using ctrl_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<ctrl_type>;
+
+    static constexpr size_type MIN_SIZE = 15;
+
+    unordered_set_v2() : unordered_set_v2(allocator_type{}) {
+    }
+
+    explicit unordered_set_v2(const allocator_type& alloc) : m_alloc(alloc), m_ctrl(swiss_ctrl::empty_group()), m_slots(nullptr), m_capacity(0), m_size(0), m_growth_left(0) {
+    }
+
+    template <typename It>
+    unordered_set_v2(It first, It last, const allocator_type& alloc = allocator_type{}) : unordered_set_v2(alloc) {
+        insert(first, last);
+    }
+
+    unordered_set_v2(std::initializer_list<value_type> ilist, const allocator_type& alloc = allocator_type{}) : unordered_set_v2(alloc) {
+        insert(ilist);
+    }
+
+    unordered_set_v2(const unordered_set_v2& other) : unordered_set_v2(std::allocator_traits<allocator_type>::select_on_container_copy_construction(other.m_alloc)) {
+        m_hash = other.m_hash;
+        m_equal = other.m_equal;
+        Max_load_factor = other.Max_load_factor;
+        reserve(other.size());
+        for (const_reference val : other)
+            insert_unique(hash_of(val), val);
+    }
+
+    unordered_set_v2(unordered_set_v2&& other) noexcept : m_hash(std::move(other.m_hash)), m_equal(std::move(other.m_equal)), m_alloc(std::move(other.m_alloc)), Max_load_factor(other.Max_load_factor), m_ctrl(std::exchange(other.m_ctrl, swiss_ctrl::empty_group())), m_slots(std::exchange(other.m_slots, nullptr)), m_capacity(std::exchange(other.m_capacity, 0)), m_size(std::exchange(other.m_size, 0)), m_growth_left(std::exchange(other.m_growth_left, 0)) {
+    }
+
+    unordered_set_v2& operator=(unordered_set_v2 other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~unordered_set_v2() {
+        destroy_slots();
+        deallocate_arrays(m_ctrl, m_slots, m_capacity);
+    }
+
+    iterator erase(const_iterator pos) {
+        const_iterator next = std::next(pos);
+        erase_slot(static_cast<size_type>(pos.ctrl() - m_ctrl));
+        return next;
+    }
+
+    size_type erase(const_reference val) {
+        iterator it = find(val);
+        if (it == end())
+            return 0;
+        erase_slot(static_cast<size_type>(it.ctrl() - m_ctrl));
+        return 1;
+    }
+
+    template <typename K>
+        requires(transparent_hash<Hash, KeyEqual> && !std::convertible_to<K, const_iterator>)
+    size_type erase(K&& key) {
+        iterator it = find(key);
+        if (it == end())
+            return 0;
+        erase_slot(static_cast<size_type>(it.ctrl() - m_ctrl));
+        return 1;
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        while (first != last)
+            first = erase(first);
+        return last;
+    }
+
+    std::pair<iterator, iterator> equal_range(const_reference val) const {
+        iterator it = find(val);
+        if (it == end())
+            return std::make_pair(it, it);
+        return std::make_pair(it, std::next(it));
+    }
+
+    size_type count(const_reference val) const {
+        return contains(val) ? 1 : 0;
+    }
+
+    iterator find(const_reference val) const {
+        size_type index = find_index(hash_of(val), val);
+        if (index == npos)
+            return end();
+        return iterator_at(index);
+    }
+
+    [[nodiscard]] bool contains(const_reference val) const {
+        return find_index(hash_of(val), val) != npos;
+    }
+
+    template <typename K>
+        requires transparent_hash<Hash, KeyEqual>
+    size_type count(const K& key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    template <typename K>
+        requires transparent_hash<Hash, KeyEqual>
+    iterator find(const K& key) const {
+        size_type index = find_index(hash_of(key), key);
+        if (index == npos)
+            return end();
+        return iterator_at(index);
+    }
+
+    template <typename K>
+        requires transparent_hash<Hash, KeyEqual>
+    [[nodiscard]] bool contains(const K& key) const {
+        return find_index(hash_of(key), key) != npos;
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        return insert(value_type(std::forward<Args>(args)...));
+    }
+
+    template <typename It>
+    void insert(It first, It last) {
+        if constexpr (std::derived_from<typename std::iterator_traits<It>::iterator_category, std::forward_iterator_tag>) {
+            reserve(size() + std::distance(first, last));
+        }
+        while (first != last)
+            insert(*first++);
+    }
+
+    void insert(std::initializer_list<value_type> ilist) {
+        reserve(size() + ilist.size());
+        for (const_reference val : ilist)
+            insert(val);
+    }
+
+    std::pair<iterator, bool> insert(const_reference val) {
+        size_type hash = hash_of(val);
+        size_type index = find_index(hash, val);
+        if (index != npos)
+            return std::make_pair(iterator_at(index), false);
+        return std::make_pair(insert_unique(hash, val), true);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& val) {
+        size_type hash = hash_of(val);
+        size_type index = find_index(hash, val);
+        if (index != npos)
+            return std::make_pair(iterator_at(index), false);
+        return std::make_pair(insert_unique(hash, std::move(val)), true);
+    }
+
+    void rehash(size_type count) {
+        count = std::max(count, static_cast<size_type>(std::ceil(size() / max_load_factor())));
+        if (count == 0) {
+            if (m_size == 0) {
+                deallocate_arrays(m_ctrl, m_slots, m_capacity);
+                m_ctrl = swiss_ctrl::empty_group();
+                m_slots = nullptr;
+                m_capacity = 0;
+                m_growth_left = 0;
+            }
+            return;
+        }
+        // capacity is always 2^n - 1 so it doubles as the probe mask
+        size_type capacity = std::bit_ceil(std::max(count, MIN_SIZE) + 1) - 1;
+        if (capacity != m_capacity || m_growth_left + m_size < capacity_to_growth(capacity))
+            resize(capacity);
+    }
+
+    void reserve(size_type count) {
+        if (count > m_size + m_growth_left)
+            rehash(std::ceil(count / max_load_factor()));
+    }
+
+    [[nodiscard]] constexpr allocator_type get_allocator() const noexcept {
+        return m_alloc;
+    }
+
+    [[nodiscard]] constexpr size_type size() const noexcept {
+        return m_size;
+    }
+
+    [[nodiscard]] constexpr bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[nodiscard]] constexpr float load_factor() const noexcept {
+        return m_capacity == 0 ? 0.0f : size() / static_cast<float>(m_capacity);
+    }
+
+    [[nodiscard]] constexpr float max_load_factor() const noexcept {
+        return Max_load_factor;
+    }
+
+    // clamped so at least one slot per table stays empty, otherwise probing for a missing key never terminates
+    constexpr void max_load_factor(float ml) noexcept {
+        Max_load_factor = std::clamp(ml, 0.1f, 0.875f);
+    }
+
+    [[nodiscard]] hasher hash_function() const {
+        return m_hash;
+    }
+
+    [[nodiscard]] key_equal key_eq() const {
+        return m_equal;
+    }
+
+    [[nodiscard]] constexpr size_type bucket_count() const noexcept {
+        return m_capacity;
+    }
+
+    void clear() {
+        destroy_slots();
+        if (m_capacity != 0)
+            reset_ctrl();
+        m_size = 0;
+        m_growth_left = capacity_to_growth(m_capacity);
+    }
+
+    constexpr void swap(unordered_set_v2& other) noexcept {
+        using std::swap;
+        swap(m_hash, other.m_hash);
+        swap(m_equal, other.m_equal);
+        swap(m_alloc, other.m_alloc);
+        swap(Max_load_factor, other.Max_load_factor);
+        swap(m_ctrl, other.m_ctrl);
+        swap(m_slots, other.m_slots);
+        swap(m_capacity, other.m_capacity);
+        swap(m_size, other.m_size);
+        swap(m_growth_left, other.m_growth_left);
+    }
+
+    [[nodiscard]] iterator begin() const {
+        iterator it(m_ctrl, m_slots);
+        it.skip_empty_or_deleted();
+        return it;
+    }
+
+    [[nodiscard]] const_iterator cbegin() const {
+        return begin();
+    }
+
+    [[nodiscard]] iterator end() const {
+        return iterator(m_ctrl + m_capacity, m_slots + m_capacity);
+    }
+
+    [[nodiscard]] const_iterator cend() const {
+        return end();
+    }
+
+private:
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+    // quadratic probing over groups, visits every group once when capacity + 1 is a power of two
+    struct probe_seq {
+        probe_seq(size_type hash, size_type mask) : m_mask(mask), m_offset(hash & mask), m_index(0) {}
+
+        [[nodiscard]] size_type offset(size_type i) const noexcept {
+            return (m_offset + i) & m_mask;
+        }
+
+        void next() noexcept {
+            m_index += swiss_group::width;
+            m_offset += m_index;
+            m_offset &= m_mask;
+        }
+
+        size_type m_mask;
+        size_type m_offset;
+        size_type m_index;
+    };
+
+    // std::hash on integers is the identity, mix so both h1 and h2 see every input bit
+    template <typename K>
+    [[nodiscard]] size_type hash_of(const K& key) const {
+        return fibonacci_mixer{}(m_hash(key));
+    }
+
+    [[nodiscard]] static constexpr size_type h1(size_type hash) noexcept {
+        return hash >> 7;
+    }
+
+    [[nodiscard]] static constexpr ctrl_type h2(size_type hash) noexcept {
+        return static_cast<ctrl_type>(hash & 0x7F);
+    }
+
+    [[nodiscard]] constexpr size_type capacity_to_growth(size_type capacity) const noexcept {
+        return std::min<size_type>(capacity - capacity / 8, static_cast<size_type>(capacity * Max_load_factor));
+    }
+
+    [[nodiscard]] iterator iterator_at(size_type index) const {
+        return iterator(m_ctrl + index, m_slots + index);
+    }
+
+    template <typename K>
+    [[nodiscard]] size_type find_index(size_type hash, const K& key) const {
+        probe_seq seq(h1(hash), m_capacity);
+        while (true) {
+            swiss_group group(m_ctrl + seq.m_offset);
+            for (int i : group.match(h2(hash))) {
+                size_type index = seq.offset(i);
+                if (m_equal(m_slots[index], key))
+                    return index;
+            }
+            if (group.match_empty())
+                return npos;
+            seq.next();
+        }
+    }
+
+    [[nodiscard]] size_type find_first_non_full(size_type hash) const {
+        probe_seq seq(h1(hash), m_capacity);
+        while (true) {
+            auto mask = swiss_group(m_ctrl + seq.m_offset).match_empty_or_deleted();
+            if (mask)
+                return seq.offset(mask.lowest());
+            seq.next();
+        }
+    }
+
+    // the first width - 1 control bytes are mirrored after the sentinel so a group load never wraps
+    void set_ctrl(size_type index, ctrl_type ctrl) {
+        m_ctrl[index] = ctrl;
+        m_ctrl[((index - (swiss_group::width - 1)) & m_capacity) + ((swiss_group::width - 1) & m_capacity)] = ctrl;
+    }
+
+    // caller guarantees val is not in the set yet
+    template <typename V>
+    iterator insert_unique(size_type hash, V&& val) {
+        size_type index = find_first_non_full(hash);
+        if (m_growth_left == 0 && m_ctrl[index] != swiss_ctrl::deleted) {
+            grow();
+            index = find_first_non_full(hash);
+        }
+        std::allocator_traits<allocator_type>::construct(m_alloc, m_slots + index, std::forward<V>(val));
+        if (m_ctrl[index] == swiss_ctrl::empty)
+            --m_growth_left;
+        set_ctrl(index, h2(hash));
+        ++m_size;
+        return iterator_at(index);
+    }
+
+    void erase_slot(size_type index) {
+        std::allocator_traits<allocator_type>::destroy(m_alloc, m_slots + index);
+        --m_size;
+        // a slot can go back to empty only if no probe sequence ever passed over a full group here
+        size_type index_before = (index - swiss_group::width) & m_capacity;
+        auto empty_after = swiss_group(m_ctrl + index).match_empty();
+        auto empty_before = swiss_group(m_ctrl + index_before).match_empty();
+        bool was_never_full = empty_before && empty_after && static_cast<size_type>(empty_after.trailing_zeros() + empty_before.leading_zeros()) < swiss_group::width;
+        set_ctrl(index, was_never_full ? swiss_ctrl::empty : swiss_ctrl::deleted);
+        if (was_never_full)
+            ++m_growth_left;
+    }
+
+    void grow() {
+        // mostly tombstones: rebuild at the same size instead of doubling
+        if (m_capacity != 0 && m_size * 32 <= m_capacity * 25)
+            resize(m_capacity);
+        else
+            resize(m_capacity == 0 ? MIN_SIZE : m_capacity * 2 + 1);
+    }
+
+    void resize(size_type capacity) {
+        ctrl_type* old_ctrl = m_ctrl;
+        pointer old_slots = m_slots;
+        size_type old_capacity = m_capacity;
+
+        allocate_arrays(capacity);
+        for (size_type i = 0; i < old_capacity; ++i) {
+            if (swiss_ctrl::is_full(old_ctrl[i])) {
+                size_type hash = hash_of(old_slots[i]);
+                size_type index = find_first_non_full(hash);
+                set_ctrl(index, h2(hash));
+                std::allocator_traits<allocator_type>::construct(m_alloc, m_slots + index, std::move(old_slots[i]));
+                std::allocator_traits<allocator_type>::destroy(m_alloc, old_slots + i);
+            }
+        }
+        m_growth_left -= m_size;
+        deallocate_arrays(old_ctrl, old_slots, old_capacity);
+    }
+
+    void allocate_arrays(size_type capacity) {
+        ctrl_allocator ctrl_alloc(m_alloc);
+        m_ctrl = std::allocator_traits<ctrl_allocator>::allocate(ctrl_alloc, capacity + swiss_group::width);
+        m_slots = std::allocator_traits<allocator_type>::allocate(m_alloc, capacity);
+        m_capacity = capacity;
+        m_growth_left = capacity_to_growth(capacity);
+        reset_ctrl();
+    }
+
+    void deallocate_arrays(ctrl_type* ctrl, pointer slots, size_type capacity) {
+        if (capacity == 0)
+            return;
+        ctrl_allocator ctrl_alloc(m_alloc);
+        std::allocator_traits<ctrl_allocator>::deallocate(ctrl_alloc, ctrl, capacity + swiss_group::width);
+        std::allocator_traits<allocator_type>::deallocate(m_alloc, slots, capacity);
+    }
+
+    void reset_ctrl() {
+        std::memset(m_ctrl, swiss_ctrl::empty, m_capacity + swiss_group::width);
+        m_ctrl[m_capacity] = swiss_ctrl::sentinel;
+    }
+
+    void destroy_slots() {
+        if constexpr (!std::is_trivially_destructible_v<value_type>) {
+            for (size_type i = 0; i < m_capacity; ++i) {
+                if (swiss_ctrl::is_full(m_ctrl[i]))
+                    std::allocator_traits<allocator_type>::destroy(m_alloc, m_slots + i);
+            }
+        }
+    }
+
+    [[no_unique_address]] hasher m_hash;
+    [[no_unique_address]] key_equal m_equal;
+    [[no_unique_address]] allocator_type m_alloc;
+    float Max_load_factor = 0.875f;
+    ctrl_type* m_ctrl;
+    pointer m_slots;
+    size_type m_capacity;
+    size_type m_size;
+    size_type m_growth_left;
+};
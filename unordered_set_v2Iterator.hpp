@@ -0,0 +1,69 @@
+#pragma once
+#include "swiss_group.hpp"
+#include <iterator>
+template <typename T>
+class unordered_set_v2Iterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    // elements of a set are immutable, so iterator and const_iterator are the same type
+    using pointer = const T*;
+    using reference = const T&;
+    using ctrl_type = swiss_ctrl::type;
+
+    unordered_set_v2Iterator() : m_ctrl(nullptr), m_slot(nullptr) {}
+
+    // ctrl must point at a full slot or at the sentinel
+    unordered_set_v2Iterator(const ctrl_type* ctrl, pointer slot) : m_ctrl(ctrl), m_slot(slot) {}
+
+    [[nodiscard]] constexpr reference operator*() const {
+        return *m_slot;
+    }
+
+    [[nodiscard]] constexpr pointer operator->() const {
+        return m_slot;
+    }
+
+    constexpr unordered_set_v2Iterator& operator++() {
+        ++m_ctrl;
+        ++m_slot;
+        skip_empty_or_deleted();
+        return *this;
+    }
+
+    constexpr unordered_set_v2Iterator operator++(int) {
+        unordered_set_v2Iterator tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+
+    [[nodiscard]] constexpr bool operator==(const unordered_set_v2Iterator& other) const noexcept {
+        return m_ctrl == other.m_ctrl;
+    }
+
+    [[nodiscard]] constexpr bool operator!=(const unordered_set_v2Iterator& other) const noexcept {
+        return !(*this == other);
+    }
+
+    [[nodiscard]] constexpr const ctrl_type* ctrl() const noexcept {
+        return m_ctrl;
+    }
+
+    [[nodiscard]] constexpr pointer slot() const noexcept {
+        return m_slot;
+    }
+
+    constexpr void skip_empty_or_deleted() {
+        while (swiss_ctrl::is_empty_or_deleted(*m_ctrl)) {
+            std::size_t shift = swiss_group(m_ctrl).count_leading_empty_or_deleted();
+            m_ctrl += shift;
+            m_slot += shift;
+        }
+    }
+
+private:
+    const ctrl_type* m_ctrl;
+    pointer m_slot;
+};
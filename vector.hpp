@@ -1,11 +1,36 @@
 #pragma once
+#include "allocator_hooks.hpp"
+#include "growth_policy.hpp"
+#include "simd_search.hpp"
+#include "trivially_relocatable.hpp"
 #include "vectorIterator.hpp"
 #include <algorithm>
 #include <bit>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
 #include <memory>
+#include <ranges>
+#include <span>
 #include <utility>
 
-template <typename T, class Alloc = std::allocator<T>>
+// selects the constructor that default initialises its elements, trivial types are then left unwritten
+struct default_init_t {
+    explicit default_init_t() = default;
+};
+inline constexpr default_init_t default_init{};
+
+// raw room for N elements inside the vector object, small_vector keeps its first elements here
+template <typename T, std::size_t N>
+struct vector_inline_storage {
+    alignas(T) std::byte bytes[N * sizeof(T)];
+};
+
+template <typename T>
+struct vector_inline_storage<T, 0> {};
+
+// Inline elements are stored in the object itself until the vector outgrows them
+template <typename T, class Alloc = std::allocator<T>, class Growth = power_of_two_growth, std::size_t Inline = 0>
 class vector {
 public:
     template <typename U>
@@ -18,39 +43,41 @@ public:
     using reference = T&;
     using const_reference = const T&;
     using allocator_type = Alloc;
+    using growth_policy = Growth;
     using iterator = vectorIterator<T>;
     using const_iterator = vectorIterator<const T>;
     using reverse_iterator = std::reverse_iterator<iterator>;
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
-    vector() noexcept(noexcept(allocator_type{})) : m_data(nullptr), m_size(0), m_capacity(0), m_alloc{allocator_type{}} {}
+    static constexpr size_type inline_capacity = Inline;
+
+    vector() noexcept(noexcept(allocator_type{})) : m_data(inline_data()), m_size(0), m_capacity(Inline), m_alloc{allocator_type{}} {}
 
-    explicit vector(const allocator_type& alloc) noexcept : m_data(nullptr), m_size(0), m_capacity(0), m_alloc{alloc} {}
+    explicit vector(const allocator_type& alloc) noexcept : m_data(inline_data()), m_size(0), m_capacity(Inline), m_alloc{alloc} {}
 
-    explicit vector(size_type size, const_reference val = value_type{}, const allocator_type& alloc = allocator_type{}) : m_data(change_capacity(std::bit_ceil(size))), m_size(0), m_capacity(std::bit_ceil(size)), m_alloc{alloc} {
+    explicit vector(size_type size, const_reference val = value_type{}, const allocator_type& alloc = allocator_type{}) : vector(alloc) {
         assign(size, val);
     }
 
+    vector(size_type size, default_init_t, const allocator_type& alloc = allocator_type{}) : vector(alloc) {
+        resize_for_overwrite(size);
+    }
+
     vector(std::initializer_list<value_type> list, const allocator_type& alloc = allocator_type{}) : vector(alloc) {
-        for (const_reference val : list)
-            push_back(val);
+        append_range(list);
     }
 
-    template <typename It>
+    template <std::input_iterator It>
     vector(It first, It last, const allocator_type& alloc = allocator_type{}) : vector(alloc) {
-        if constexpr (std::is_same_v<std::contiguous_iterator_tag, typename std::iterator_traits<It>::iterator_category>) {
-            reserve(last - first);
-        }
-        while (first != last)
-            push_back(*first++);
+        append_range(std::ranges::subrange(first, last));
     }
 
     vector(const vector& other) : vector(other.cbegin(), other.cend(), other.get_allocator()) {
         // copy constructor
     }
 
-    vector(vector&& other) : m_data(std::exchange(other.data(), nullptr)), m_size(std::exchange(other.size(), 0)), m_capacity(std::exchange(other.capacity(), 0)), m_alloc(other.get_allocator()) {
-        // move constructor
+    vector(vector&& other) noexcept(nothrow_steal) : vector(other.get_allocator()) {
+        steal(other);
     }
 
     vector& operator=(const vector& other) {
@@ -60,11 +87,15 @@ public:
         return *this;
     }
 
-    vector& operator=(vector&& other) noexcept {
-        m_data = std::exchange(other.data(), nullptr);
-        m_size = std::exchange(other.size(), 0);
-        m_capacity = std::exchange(other.capacity(), 0);
+    vector& operator=(vector&& other) noexcept(nothrow_steal) {
+        if (this == &other)
+            return *this;
+        clear();
+        free_data(m_data);
+        m_data = inline_data();
+        m_capacity = Inline;
         m_alloc = other.get_allocator();
+        steal(other);
         return *this;
     }
 
@@ -80,24 +111,24 @@ public:
 
     void constexpr push_back(const_reference val) {
         if (size() >= capacity())
-            increase_capacity(capacity() * 2);
+            increase_capacity(growth_policy::grow(capacity(), size() + 1, sizeof(value_type)));
         std::construct_at(&m_data[m_size++], val);
     }
 
     void constexpr push_back(value_type&& val) {
         if (size() >= capacity())
-            increase_capacity(capacity() * 2);
+            increase_capacity(growth_policy::grow(capacity(), size() + 1, sizeof(value_type)));
         std::construct_at(&m_data[m_size++], std::move(val));
     }
 
     template <typename... Args>
     reference constexpr emplace_back(Args&&... args) {
         if (size() >= capacity())
-            increase_capacity(capacity() * 2);
-        return std::construct_at(&m_data[m_size++], std::forward<Args>(args)...);
+            increase_capacity(growth_policy::grow(capacity(), size() + 1, sizeof(value_type)));
+        return *std::construct_at(&m_data[m_size++], std::forward<Args>(args)...);
     }
 
-    constexpr void clear() noexcept(noexcept(~value_type())) {
+    constexpr void clear() noexcept(std::is_nothrow_destructible_v<value_type>) {
         delete_data(size());
         m_size = 0;
     }
@@ -115,70 +146,133 @@ public:
             push_back(val);
     }
 
-    template <typename It>
+    template <std::input_iterator It>
     constexpr void assign(It first, It last) {
-        clear();
-        if constexpr (std::is_same_v<std::contiguous_iterator_tag, typename std::iterator_traits<It>::iterator_category>) {
-            reserve(std::distance(first, last));
-        }
-        while (first != last)
-            push_back(*first++);
+        assign_range(std::ranges::subrange(first, last));
     }
 
     constexpr void assign(std::initializer_list<value_type> list) {
+        assign_range(list);
+    }
+
+    // sized and forward ranges check the capacity once, contiguous ranges of trivially copyable elements are
+    // copied with one memcpy; input ranges of unknown length fill whatever capacity is free before growing again
+    template <std::ranges::input_range R>
+    constexpr void append_range(R&& range) {
+        if constexpr (std::ranges::forward_range<R> || std::ranges::sized_range<R>) {
+            size_type count = static_cast<size_type>(std::ranges::distance(range));
+            if (size() + count > capacity())
+                increase_capacity(growth_policy::grow(capacity(), size() + count, sizeof(value_type)));
+            if constexpr (std::ranges::contiguous_range<R> && std::is_trivially_copyable_v<value_type> &&
+                          std::is_same_v<std::ranges::range_value_t<R>, value_type>) {
+                if (count != 0)
+                    std::memcpy(static_cast<void*>(m_data + size()), std::ranges::data(range), count * sizeof(value_type));
+                m_size += count;
+            } else {
+                auto it = std::ranges::begin(range);
+                for (size_type i = 0; i < count; ++i, ++it) {
+                    std::allocator_traits<allocator_type>::construct(m_alloc, &m_data[m_size], *it);
+                    ++m_size;
+                }
+            }
+        } else {
+            auto it = std::ranges::begin(range);
+            auto last = std::ranges::end(range);
+            while (it != last) {
+                if (size() == capacity())
+                    increase_capacity(growth_policy::grow(capacity(), size() + 1, sizeof(value_type)));
+                for (size_type room = capacity() - size(); room != 0 && it != last; --room, ++it) {
+                    std::allocator_traits<allocator_type>::construct(m_alloc, &m_data[m_size], *it);
+                    ++m_size;
+                }
+            }
+        }
+    }
+
+    template <std::ranges::input_range R>
+    constexpr void assign_range(R&& range) {
         clear();
-        for (const_reference val : list)
-            push_back(val);
+        append_range(std::forward<R>(range));
     }
 
     template <typename... Args>
     constexpr iterator emplace(const_iterator pos, Args&&... args) {
         size_type index = pos - cbegin();
-        emplace_back(std::forward<Args>(args)...);
-        partition(index, 1);
+        if constexpr (is_trivially_relocatable_v<value_type>) {
+            // built aside first, args may refer to elements the gap is about to move
+            alignas(value_type) std::byte tmp[sizeof(value_type)];
+            value_type* val = std::construct_at(reinterpret_cast<value_type*>(tmp), std::forward<Args>(args)...);
+            try {
+                open_gap(index, 1);
+            } catch (...) {
+                std::destroy_at(val);
+                throw;
+            }
+            std::memcpy(static_cast<void*>(m_data + index), tmp, sizeof(value_type));
+            ++m_size;
+        } else {
+            value_type val(std::forward<Args>(args)...);
+            insert_n(index, 1, [&val]() -> value_type&& { return std::move(val); });
+        }
         return begin() + index;
     }
 
     constexpr iterator insert(const_iterator pos, const_reference val) {
-        return insert(pos, static_cast<size_type>(1), val);
+        return emplace(pos, val);
     }
 
     constexpr iterator insert(const_iterator pos, value_type&& val) {
-        size_type index = pos - cbegin();
-        push_back(std::move(val));
-        partition(index, 1);
-        return begin() + index;
+        return emplace(pos, std::move(val));
     }
 
     constexpr iterator insert(const_iterator pos, size_type count, const_reference val) {
         size_type index = pos - cbegin();
-        for (size_type i = 0; i < count; ++i)
-            push_back(val);
-        partition(index, count);
+        if constexpr (is_trivially_relocatable_v<value_type>) {
+            if (count == 0)
+                return begin() + index;
+            alignas(value_type) std::byte tmp[sizeof(value_type)];
+            value_type* copy = std::construct_at(reinterpret_cast<value_type*>(tmp), val);
+            try {
+                open_gap(index, count);
+                construct_gap(index, count - 1, [this, copy](pointer p) { std::allocator_traits<allocator_type>::construct(m_alloc, p, *copy); });
+            } catch (...) {
+                std::destroy_at(copy);
+                throw;
+            }
+            std::memcpy(static_cast<void*>(m_data + index + count - 1), tmp, sizeof(value_type));
+            m_size += count;
+        } else if (count != 0) {
+            value_type copy(val);
+            insert_n(index, count, [&copy]() -> const_reference { return copy; });
+        }
         return begin() + index;
     }
 
-    template <typename It>
+    template <std::input_iterator It>
     constexpr iterator insert(const_iterator pos, It first, It last) {
         size_type index = pos - cbegin();
-        size_type count = 0;
-        while (first != last) {
-            push_back(*first++);
-            ++count;
+        if constexpr (std::derived_from<typename std::iterator_traits<It>::iterator_category, std::forward_iterator_tag>) {
+            size_type count = std::distance(first, last);
+            if (count == 0)
+                return begin() + index;
+            if constexpr (is_trivially_relocatable_v<value_type>) {
+                open_gap(index, count);
+                construct_gap(index, count, [this, &first](pointer p) { std::allocator_traits<allocator_type>::construct(m_alloc, p, *first++); });
+                m_size += count;
+            } else {
+                insert_n(index, count, [&first]() -> decltype(auto) { return *first++; });
+            }
+        } else {
+            // length unknown up front: append, then rotate the new elements into place
+            size_type old_size = size();
+            append_range(std::ranges::subrange(first, last));
+            std::rotate(m_data + index, m_data + old_size, m_data + size());
         }
-        partition(index, count);
         return begin() + index;
     }
 
     constexpr iterator insert(const_iterator pos, std::initializer_list<T> list) {
-        size_type index = pos - cbegin();
-        size_type count = 0;
-        for (const_reference n : list) {
-            push_back(n);
-            ++count;
-        }
-        partition(index, count);
-        return begin() + index;
+        return insert(pos, list.begin(), list.end());
     }
 
     iterator constexpr erase(iterator pos) {
@@ -188,13 +282,20 @@ public:
     iterator constexpr erase(iterator first, iterator last) {
         if (first == last)
             return first;
+        if constexpr (is_trivially_relocatable_v<value_type>) {
+            size_type index = first - begin();
+            size_type count = last - first;
+            if constexpr (!std::is_trivially_destructible_v<value_type>) {
+                for (size_type i = index; i < index + count; ++i)
+                    std::allocator_traits<allocator_type>::destroy(m_alloc, &m_data[i]);
+            }
+            std::memmove(static_cast<void*>(m_data + index), m_data + index + count, (size() - index - count) * sizeof(value_type));
+            m_size -= count;
+            return begin() + index;
+        }
         iterator tmp = first;
         while (last != end()) {
-            if constexpr (std::is_trivially_copyable_v<value_type>) {
-                memmove(&(*first), &(*last), (end() - last) * sizeof(value_type));
-                first += end() - last;
-                break;
-            } else if constexpr (std::is_nothrow_constructible_v<value_type>) {
+            if constexpr (std::is_nothrow_move_assignable_v<value_type>) {
                 *first++ = std::move(*last++);
             } else {
                 *first++ = *last++;
@@ -207,7 +308,8 @@ public:
     }
 
     void reserve(size_type size) {
-        increase_capacity(std::bit_ceil(size));
+        if (size > capacity())
+            increase_capacity(growth_policy::reserve(size, sizeof(value_type)));
     }
 
     void resize(size_type count, const_reference val = value_type{}) {
@@ -217,6 +319,27 @@ public:
             push_back(val);
     }
 
+    // like resize, but new elements are default initialised: trivial types keep whatever the buffer held,
+    // for buffers that are about to be overwritten anyway (reads from a file or socket)
+    void resize_for_overwrite(size_type count) {
+        while (size() > count)
+            pop_back();
+        if (size() < count) {
+            reserve(count);
+            std::uninitialized_default_construct(m_data + size(), m_data + count);
+            m_size = count;
+        }
+    }
+
+    // grows the vector by count default initialised elements and returns them for the caller to fill
+    [[nodiscard]] std::span<value_type> append_uninitialized(size_type count) {
+        if (size() + count > capacity())
+            increase_capacity(growth_policy::grow(capacity(), size() + count, sizeof(value_type)));
+        std::uninitialized_default_construct(m_data + size(), m_data + size() + count);
+        m_size += count;
+        return std::span<value_type>(m_data + size() - count, count);
+    }
+
     [[nodiscard]] allocator_type get_allocator() const {
         return m_alloc;
     }
@@ -278,7 +401,20 @@ public:
     }
 
     void constexpr shrink_to_fit() {
-        increase_capacity(std::max(size(), std::bit_ceil(size())));
+        if (is_inline())
+            return;
+        if constexpr (Inline != 0) {
+            if (size() <= Inline) {
+                T* heap = m_data;
+                relocate_elements(heap, size(), inline_data());
+                std::allocator_traits<allocator_type>::deallocate(m_alloc, heap, capacity());
+                m_data = inline_data();
+                m_capacity = Inline;
+                return;
+            }
+        }
+        if (capacity() > std::max<size_type>(size(), 4))
+            increase_capacity(size());
     }
 
     [[nodiscard]] constexpr iterator begin() {
@@ -321,8 +457,18 @@ public:
         return crend();
     }
 
-    constexpr void swap(vector& other) noexcept(noexcept(std::swap(other, *this))) {
-        std::swap(other, *this);
+    // inline elements cannot trade places by pointer, those are moved through a temporary
+    constexpr void swap(vector& other) noexcept(nothrow_steal) {
+        if (is_inline() || other.is_inline()) {
+            vector tmp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(tmp);
+            return;
+        }
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_alloc, other.m_alloc);
     }
 
     [[nodiscard]] constexpr bool operator==(const vector& other) const {
@@ -330,33 +476,36 @@ public:
             return false;
         if (other.data() == m_data)
             return true;
-        auto first = begin();
-        auto it = other.begin();
-        auto last = end();
-        while (first != last) {
-            if (*first++ != *it++)
-                return false;
-        }
-        return true;
+        return simd_equal(data(), other.data(), size());
     }
 
-private:
-    constexpr void partition(size_type index, size_type count) {
-        if (count == 0)
-            return;
-        std::reverse(begin() + index, end());
-        std::reverse(begin() + index, begin() + index + count);
-        std::reverse(begin() + index + count, end());
+    [[nodiscard]] constexpr iterator find(const_reference val) {
+        return begin() + simd_find(data(), size(), val);
     }
 
-    [[nodiscard]] constexpr T* change_capacity(size_type size, size_type msize = 0) {
-        T* newData = m_alloc.allocate(size);
-        if constexpr (std::is_trivially_constructible_v<value_type>) {
-            memcpy(newData, m_data, msize * sizeof(value_type));
+    [[nodiscard]] constexpr const_iterator find(const_reference val) const {
+        return begin() + simd_find(data(), size(), val);
+    }
+
+    [[nodiscard]] constexpr size_type count(const_reference val) const {
+        return simd_count(data(), size(), val);
+    }
+
+    [[nodiscard]] constexpr bool contains(const_reference val) const {
+        return simd_find(data(), size(), val) != size();
+    }
+
+private:
+    // moves the first msize elements into a new buffer of size elements, relocatable types are copied bytewise
+    // and the old buffer then holds no live objects
+    [[nodiscard]] constexpr T* change_capacity(size_type& size, size_type msize = 0) {
+        T* newData = allocate_buffer(size);
+        if constexpr (is_trivially_relocatable_v<value_type>) {
+            if (msize != 0)
+                std::memcpy(static_cast<void*>(newData), m_data, msize * sizeof(value_type));
         } else {
             for (size_type i = 0; i < msize; i++) {
-                
-                if constexpr (std::is_nothrow_move_assignable_v<value_type>) {
+                if constexpr (std::is_nothrow_move_constructible_v<value_type>) {
                     std::allocator_traits<allocator_type>::construct(m_alloc, &newData[i], std::move(m_data[i]));
                 } else {
                     std::allocator_traits<allocator_type>::construct(m_alloc, &newData[i], m_data[i]);
@@ -368,24 +517,228 @@ private:
 
     constexpr void delete_data(size_type size) {
         if constexpr (!std::is_trivially_destructible_v<value_type>) {
-            for (int i = 0; i < size; i++) {
+            for (size_type i = 0; i < size; i++) {
                 std::allocator_traits<allocator_type>::template destroy(m_alloc, &m_data[i]);
             }
         }
     }
 
     constexpr void free_data(T* data) {
-        std::allocator_traits<allocator_type>::deallocate(m_alloc, data, capacity());
+        if (data != inline_data())
+            std::allocator_traits<allocator_type>::deallocate(m_alloc, data, capacity());
+    }
+
+    [[nodiscard]] constexpr T* inline_data() noexcept {
+        if constexpr (Inline == 0)
+            return nullptr;
+        else
+            return reinterpret_cast<T*>(&m_inline);
+    }
+
+    // true while the elements live in the inline storage, always true for an unallocated plain vector
+    [[nodiscard]] constexpr bool is_inline() noexcept {
+        return m_data == inline_data();
+    }
+
+    static constexpr bool nothrow_steal = Inline == 0 || std::is_nothrow_move_constructible_v<value_type>;
+
+    // takes other's elements into this empty, inline vector: a heap buffer changes owner, inline elements
+    // are moved over one by one; other is left empty and inline
+    constexpr void steal(vector& other) noexcept(nothrow_steal) {
+        if (!other.is_inline()) {
+            m_data = std::exchange(other.m_data, other.inline_data());
+            m_size = std::exchange(other.m_size, 0);
+            m_capacity = std::exchange(other.m_capacity, Inline);
+            return;
+        }
+        if constexpr (Inline != 0) {
+            relocate_elements(other.m_data, other.size(), m_data);
+            m_size = std::exchange(other.m_size, 0);
+        }
+    }
+
+    // moves count elements from src into raw storage at dest and ends them at src
+    constexpr void relocate_elements(pointer src, size_type count, pointer dest) {
+        if constexpr (is_trivially_relocatable_v<value_type>) {
+            if (count != 0)
+                std::memcpy(static_cast<void*>(dest), src, count * sizeof(value_type));
+        } else {
+            relocate_range(src, src + count, dest);
+            std::destroy(src, src + count);
+        }
+    }
+
+    // size is raised to the number of elements the allocator actually handed out
+    [[nodiscard]] constexpr T* allocate_buffer(size_type& size) {
+        if constexpr (allocates_at_least<allocator_type>) {
+            auto result = m_alloc.allocate_at_least(size);
+            size = result.count;
+            return result.ptr;
+        } else {
+            return m_alloc.allocate(size);
+        }
+    }
+
+    // lets the allocator resize the current buffer itself, either in place or realloc style for relocatable types;
+    // false when it cannot and the caller has to allocate and move
+    constexpr bool resize_buffer(size_type new_capacity) {
+        if (is_inline())
+            return false;
+        if constexpr (expandable_allocator<allocator_type>) {
+            if (new_capacity > capacity() && m_alloc.try_expand(m_data, capacity(), new_capacity)) {
+                m_capacity = new_capacity;
+                return true;
+            }
+        }
+        if constexpr (reallocating_allocator<allocator_type> && is_trivially_relocatable_v<value_type>) {
+            m_data = m_alloc.reallocate(m_data, capacity(), new_capacity);
+            m_capacity = new_capacity;
+            return true;
+        }
+        return false;
     }
 
     constexpr void increase_capacity(size_type new_size) {
-        T* new_data = change_capacity(std::max<size_type>(new_size, 4), size());
+        new_size = std::max<size_type>(new_size, 4);
+        if (resize_buffer(new_size))
+            return;
+        T* new_data = change_capacity(new_size, size());
+        if constexpr (!is_trivially_relocatable_v<value_type>)
+            delete_data(size());
+        free_data(m_data);
+        m_capacity = new_size;
+        m_data = new_data;
+    }
+
+    // moves [first, last) into raw storage at dest, copying when a move could throw; on a throw nothing is left built
+    constexpr void relocate_range(pointer first, pointer last, pointer dest)
+        requires(!is_trivially_relocatable_v<value_type>)
+    {
+        if constexpr (std::is_nothrow_move_constructible_v<value_type>)
+            std::uninitialized_move(first, last, dest);
+        else
+            std::uninitialized_copy(first, last, dest);
+    }
+
+    // inserts count elements produced by value_at() in order at index with a single shift of the tail:
+    // the last elements move into raw storage past the end, the rest move backward, the gap is then assigned
+    // where it still holds moved from elements and constructed past the old end; when the buffer is full the
+    // new elements are built in the new buffer first and the old ones moved around them
+    // basic guarantee, a throw while filling the gap drops the elements after it
+    template <typename F>
+    constexpr void insert_n(size_type index, size_type count, F value_at)
+        requires(!is_trivially_relocatable_v<value_type>)
+    {
+        // with nothing to insert the tail would be moved onto itself
+        if (count == 0)
+            return;
+        size_type old_size = size();
+        if (old_size + count > capacity()) {
+            size_type new_capacity = std::max<size_type>(growth_policy::grow(capacity(), old_size + count, sizeof(value_type)), 4);
+            if (!resize_buffer(new_capacity)) {
+                insert_realloc(index, count, new_capacity, value_at);
+                return;
+            }
+        }
+        size_type live = std::min(count, old_size - index);
+        relocate_range(m_data + old_size - live, m_data + old_size, m_data + old_size - live + count);
+        size_type built = live;
+        m_size = index + live;
+        try {
+            std::move_backward(m_data + index, m_data + old_size - live, m_data + old_size);
+            for (size_type i = 0; i < live; ++i)
+                m_data[index + i] = value_at();
+            for (; built < count; ++built)
+                std::allocator_traits<allocator_type>::construct(m_alloc, &m_data[index + built], value_at());
+        } catch (...) {
+            for (size_type i = index + live; i < index + built; ++i)
+                std::allocator_traits<allocator_type>::destroy(m_alloc, &m_data[i]);
+            for (size_type i = index + count; i < old_size + count; ++i)
+                std::allocator_traits<allocator_type>::destroy(m_alloc, &m_data[i]);
+            throw;
+        }
+        m_size = old_size + count;
+    }
+
+    template <typename F>
+    constexpr void insert_realloc(size_type index, size_type count, size_type new_capacity, F& value_at)
+        requires(!is_trivially_relocatable_v<value_type>)
+    {
+        T* new_data = allocate_buffer(new_capacity);
+        size_type built = 0;
+        try {
+            for (; built < count; ++built)
+                std::allocator_traits<allocator_type>::construct(m_alloc, &new_data[index + built], value_at());
+            relocate_range(m_data, m_data + index, new_data);
+            try {
+                relocate_range(m_data + index, m_data + size(), new_data + index + count);
+            } catch (...) {
+                std::destroy(new_data, new_data + index);
+                throw;
+            }
+        } catch (...) {
+            std::destroy(new_data + index, new_data + index + built);
+            std::allocator_traits<allocator_type>::deallocate(m_alloc, new_data, new_capacity);
+            throw;
+        }
         delete_data(size());
         free_data(m_data);
-        m_capacity = std::max<size_type>(new_size, 4);
         m_data = new_data;
+        m_capacity = new_capacity;
+        m_size += count;
+    }
+
+    // shifts [index, size) up by count with one memmove, or relocates around the gap into a bigger buffer;
+    // m_size is left alone, the caller fills the gap and then adds count
+    constexpr void open_gap(size_type index, size_type count)
+        requires is_trivially_relocatable_v<value_type>
+    {
+        // an empty gap on a vector that never allocated would hand memmove a null pointer
+        if (count == 0)
+            return;
+        if (size() + count <= capacity()) {
+            std::memmove(static_cast<void*>(m_data + index + count), m_data + index, (size() - index) * sizeof(value_type));
+            return;
+        }
+        size_type new_capacity = std::max<size_type>(growth_policy::grow(capacity(), size() + count, sizeof(value_type)), 4);
+        if (resize_buffer(new_capacity)) {
+            std::memmove(static_cast<void*>(m_data + index + count), m_data + index, (size() - index) * sizeof(value_type));
+            return;
+        }
+        T* new_data = allocate_buffer(new_capacity);
+        if (index != 0)
+            std::memcpy(static_cast<void*>(new_data), m_data, index * sizeof(value_type));
+        if (index != size())
+            std::memcpy(static_cast<void*>(new_data + index + count), m_data + index, (size() - index) * sizeof(value_type));
+        free_data(m_data);
+        m_data = new_data;
+        m_capacity = new_capacity;
+    }
+
+    constexpr void close_gap(size_type index, size_type count)
+        requires is_trivially_relocatable_v<value_type>
+    {
+        std::memmove(static_cast<void*>(m_data + index), m_data + index + count, (size() - index) * sizeof(value_type));
+    }
+
+    // construct_one builds one element at the address it is given; on a throw the gap is closed again
+    template <typename F>
+    constexpr void construct_gap(size_type index, size_type count, F construct_one)
+        requires is_trivially_relocatable_v<value_type>
+    {
+        size_type built = 0;
+        try {
+            for (; built < count; ++built)
+                construct_one(&m_data[index + built]);
+        } catch (...) {
+            for (size_type i = 0; i < built; ++i)
+                std::allocator_traits<allocator_type>::destroy(m_alloc, &m_data[index + i]);
+            close_gap(index, count);
+            throw;
+        }
     }
 
+    [[no_unique_address]] vector_inline_storage<T, Inline> m_inline;
     T* m_data;
     size_type m_size;
     size_type m_capacity;
@@ -6,7 +6,9 @@ class vectorIterator {
 public:
     friend class vectorIterator<const T>;
     using iterator_category = std::contiguous_iterator_tag;
-    using value_type = T;
+    using iterator_concept = std::contiguous_iterator_tag;
+    using value_type = std::remove_const_t<T>;
+    using element_type = T;
     using size_type = std::size_t;
     using difference_type = std::ptrdiff_t;
     using pointer = T*;
@@ -14,20 +16,24 @@ public:
     using reference = T&;
     using const_reference = const T&;
 
-    explicit vectorIterator(pointer data) : m_data(data) {}
+    vectorIterator() = default;
 
-    vectorIterator(const vectorIterator& other) : m_data(other.m_data) {
-    }
+    explicit vectorIterator(pointer data) : m_data(data) {}
 
     constexpr operator vectorIterator<const T>() const {
         return vectorIterator<const T>(m_data);
     }
 
-    [[nodiscard]] constexpr reference operator*() {
+    [[nodiscard]] constexpr reference operator*() const {
         return *m_data;
     }
-    [[nodiscard]] constexpr const_reference operator*() const {
-        return *m_data;
+
+    [[nodiscard]] constexpr pointer operator->() const {
+        return m_data;
+    }
+
+    [[nodiscard]] constexpr reference operator[](difference_type index) const {
+        return m_data[index];
     }
 
     constexpr vectorIterator& operator++() {
@@ -52,25 +58,29 @@ public:
         return tmp;
     }
 
-    constexpr vectorIterator& operator+=(size_type val) {
-        std::advance(m_data, val);
+    constexpr vectorIterator& operator+=(difference_type val) {
+        m_data += val;
         return *this;
     }
 
-    constexpr vectorIterator& operator-=(size_type val) {
-        std::advance(m_data, -val);
+    constexpr vectorIterator& operator-=(difference_type val) {
+        m_data -= val;
         return *this;
     }
 
-    constexpr vectorIterator operator+(size_type val) {
+    [[nodiscard]] constexpr vectorIterator operator+(difference_type val) const {
         return vectorIterator(m_data + val);
     }
 
-    constexpr vectorIterator operator-(size_type val) {
+    [[nodiscard]] friend constexpr vectorIterator operator+(difference_type val, const vectorIterator& it) {
+        return it + val;
+    }
+
+    [[nodiscard]] constexpr vectorIterator operator-(difference_type val) const {
         return vectorIterator(m_data - val);
     }
 
-    constexpr size_type operator-(vectorIterator other) {
+    [[nodiscard]] constexpr difference_type operator-(const vectorIterator& other) const {
         return m_data - other.m_data;
     }
 
@@ -99,5 +109,5 @@ public:
     }
 
 private:
-    T* m_data;
-};
\ No newline at end of file
+    T* m_data = nullptr;
+};